@@ -1,12 +1,35 @@
-#include <iostream>    // cout, cerr, cin, endl
-#include <iomanip>     // setw, setfill, etc
 #include <string>      // string
-#include <algorithm>   // transform
 #include <string_view> // string_view
-#include <cstring>     // strncpy
+#include <vector>      // vector
+#include <charconv>    // from_chars, to_chars
+#include <cstring>     // memcpy, memmove, strerror
+#include <cerrno>      // errno
+#include <algorithm>   // max
+#include <deque>       // deque
+#include <functional>  // function
+#include <memory>      // unique_ptr
+#include <thread>      // thread
+#include <mutex>       // mutex
+#include <condition_variable> // condition_variable
+#include <future>      // promise
+#include <chrono>      // steady_clock
+#include <unordered_map> // unordered_map
+#include <csignal>     // sigset_t, SIGINT, SIGTERM
+#include <unistd.h>    // read, write, isatty, close
+#include <fcntl.h>     // open
+#include <sys/stat.h>  // fstat
+#include <sys/mman.h>  // mmap, madvise
+#include <sys/socket.h> // socket, bind, listen, accept4, send
+#include <sys/un.h>    // sockaddr_un
+#include <sys/epoll.h> // epoll_create1, epoll_ctl, epoll_wait
+#include <sys/signalfd.h> // signalfd
+#include <sys/syscall.h> // __NR_io_uring_setup, __NR_io_uring_enter
+#include <linux/io_uring.h> // io_uring_params, io_uring_sqe, io_uring_cqe
+
+#include "ieee754.hpp" // IEEE754Float, parsing and formatting
 #include <cmath>       // float functions (isnormal, isnan, isfinite, etc)
-#include <stdexcept>   // for stoi's error output
 #include <cfloat>      // FLT_HAS_SUBNORM
+#include <limits>      // numeric_limits
 
 
 #ifndef __STDC_IEC_559__
@@ -22,8 +45,11 @@ namespace
     /*
      * Help string.
      */
-    const static std::string helpStr = R"HELP(Usage: float <flags>
+    const static std::string helpStr = R"HELP(Usage: float <flags> [files]
 Takes in data as a hexadecimal value (from standard in) and outputs its floating-point representation. 
+With -b, standard in holds the raw bytes of the values instead.
+If files are given, they are read in order instead of standard in ("-" is
+standard in). Flags inside a file stay in effect for the next one.
 
 Flags:
     Flags can be set as an argument or in stdin. To call a flag:
@@ -31,23 +57,274 @@ Flags:
     
 Flags include:
     -h                                    Help
-    -p<number>                            Floating point precison.
+    -p<number>                            Floating point precison, at most
+                                          11563 (more digits are all zeros).
+    -r                                    Shortest output that converts back
+                                          to the same bits (until -p).
     -s                                    Simple output (no table).
     -n                                    Normal out (defaults).
+    -c                                    Summary: instead of each value, print
+                                          how many values of each sign and
+                                          class, and of each exponent, the
+                                          input had. Command line only.
+    --only=<filter,...>                   Only print values that match: any of
+                                          the listed classes (zero, subnormal,
+                                          normal, infinity, nan), signs
+                                          (positive, negative), and
+                                          exp=LO:HI, a range of unbiased
+                                          exponents. --only=all prints all.
+    -x[0]                                 Read decimal numbers and print their
+                                          bits in hex, correctly rounded to
+                                          the type of -t (double by default,
+                                          half, bfloat16 and binary128 are not
+                                          supported). -x0 goes back to hex.
+    -t<a|h|b|f|d|x|q>                     Type of the hex input: a (default)
+                                          goes by the number of digits, up to
+                                          8 for float, 16 double, 20 x87 80 bit
+                                          extended, 32 binary128. h is IEEE
+                                          half, b bfloat16, f float, d double,
+                                          x x87 extended, q binary128.
+    -o<text|json|csv>                     Output format. json and csv write one
+                                          record per value with the fields
+                                          hex,type,value,sign,exponent,
+                                          mantissa,class (exponent is biased,
+                                          mantissa is the stored fraction).
+    -b<4|8>[l|b]                          Read raw 4 byte floats or 8 byte
+                                          doubles instead of hex text, little
+                                          (default) or big endian. Command
+                                          line only.
+    --dump=<xxd|od|hexdump|gdb>[:<4|8>[l|b]]
+                                          Read the bytes shown by a hex dump
+                                          (xxd, od -x or -t x<n>, hexdump or
+                                          hexdump -C, gdb's x/x) as raw
+                                          values, like -b: addresses and ASCII
+                                          columns are skipped, od's, hexdump's
+                                          and gdb's words are taken as little
+                                          endian, and "*" lines repeat the
+                                          line before. Values are 4 byte
+                                          little endian ones by default.
+                                          Not with --listen or --diff.
+                                          Command line only.
+    -j<number>                            Convert with this many threads (0 for
+                                          one per CPU). Output stays in input
+                                          order. Command line only.
+    --listen=<path>                       Serve on a Unix socket at path
+                                          instead of converting files. Each
+                                          connection is converted like
+                                          standard in, starting from the
+                                          command line's settings, and its
+                                          output and errors are sent back on
+                                          it. Runs until SIGINT or SIGTERM.
+                                          Command line only.
+    --errors=<number|all>                 Write out only this many of the
+                                          tokens that were not recognized
+                                          (all by default), and at the end,
+                                          how many there were of each error.
+                                          Each is one line, with its line and
+                                          byte in the input. Command line only.
+    --stats                               At the end, write to standard error
+                                          how many tokens, values of each
+                                          format and class, and bytes were
+                                          read and written, the wall time,
+                                          and the time spent tokenizing,
+                                          parsing, rendering and writing.
+                                          Command line only.
+    --cache=<number>                      Keep the output of up to this many
+                                          values (per thread), and copy it
+                                          when the same bits are printed again
+                                          with the same settings, instead of
+                                          formatting them. For input with many
+                                          repeated values. --stats reports the
+                                          hits and misses. 0 (the default)
+                                          turns it off. Command line only.
+    --sweep=<lo>:<hi>[:<stride>]          Instead of reading input, print (or
+                                          with -c count) the values with the
+                                          bits lo, lo + stride, ... up to hi,
+                                          as if their hex had been read. lo
+                                          and hi are hex, and give the type
+                                          like input does unless -t is set;
+                                          stride is a number (1 by default).
+                                          -j splits the range between
+                                          threads, output stays in order.
+                                          Command line only.
+    --diff                                Compare the hex values of two files
+                                          (given after the flags), the first
+                                          value of one with the first of the
+                                          other and so on. Each pair that
+                                          differs is printed with its hex and
+                                          shortest decimals, how many values
+                                          of the type apart the two are (ulp),
+                                          and how the exponent, mantissa, sign
+                                          and class changed; at the end, how
+                                          many differed and the largest and
+                                          mean distance. Values are read by
+                                          -t; flags in the files are not.
+                                          Command line only.
+    --io=<auto|uring|sync>                How input and output are done. auto
+                                          (the default) keeps reads in flight
+                                          ahead of the conversion, and writes
+                                          output while the next is converted,
+                                          with io_uring; regular files are
+                                          memory mapped instead of read.
+                                          uring reads regular files with
+                                          io_uring too. sync reads and writes
+                                          with read() and write(), which is
+                                          also what is done if the kernel
+                                          does not allow io_uring. Command
+                                          line only.
 
 
 Return values:
     -2 if an unrecognized command line argument was found.
-    -1 if an error occurred while reading from stdin.
+    -1 if an error occurred while opening or reading the input, writing
+       the output, or setting up the socket.
      0 on success.
-    >0 The number of inputs that were not recognized. 
+    >0 The number of inputs that were not recognized. With --diff, the
+       number of pairs that differ.
 )HELP";
 
     /*
-     * String describing the last error that .
+     * Why a token was not recognized.
      */
-    
-    static std::string lastErrorMsg;
+    enum class Error : unsigned char
+    {
+        None,
+        NotAValue,
+        Empty,
+        ShortFlag,
+        UnknownFlag,
+        NoPrecision,
+        BadPrecision,
+        BadType,
+        BadFormat,
+        BinaryCommandLine,
+        BadRawSize,
+        BadByteOrder,
+        ThreadsCommandLine,
+        BadThreads,
+        SummaryCommandLine,
+        BadReverse,
+        BadExponentRange,
+        UnknownFilter,
+        ListenCommandLine,
+        NoSocketPath,
+        StatsCommandLine,
+        ErrorsCommandLine,
+        BadErrorLimit,
+        CacheCommandLine,
+        BadCacheSize,
+        SweepCommandLine,
+        BadSweep,
+        SweepType,
+        SweepReversed,
+        DiffCommandLine,
+        DumpCommandLine,
+        UnknownDump,
+        IoCommandLine,
+        UnknownIo,
+        FilesWithListen,
+        FilesWithSweep,
+        DumpWithListen,
+        DumpWithDiff,
+        DiffNeedsTwoFiles,
+        BadInput,
+        IncompleteValue,
+    };
+
+    constexpr unsigned numErrors = static_cast<unsigned>(::Error::IncompleteValue) + 1;
+
+    /*
+     * An error's name, for the counts of --errors, and its message: before,
+     * the detail the error was found with (part of the token), then after.
+     */
+    struct ErrorText
+    {
+        const char *name;
+        const char *before;
+        const char *after;
+    };
+
+    constexpr ::ErrorText errorTexts[numErrors] =
+    {
+        { "none",                 "", "" },
+        { "not a value",          "", "" },
+        { "empty",                "Empty input.", "" },
+        { "short flag",           "Not enough arguments for a flag.", "" },
+        { "unknown flag",         "Unrecognized input: ", "" },
+        { "no precision",         "Precision was not set with value.", "" },
+        { "bad precision",        "While trying to set the float precision: ",
+                                  " is not a valid number." },
+        { "bad type",             "Type must be one of a, h, b, f, d, x, q.", "" },
+        { "bad output format",    "Output format must be text, json or csv.", "" },
+        { "command line only",    "Binary input can only be selected on the command line.", "" },
+        { "bad raw size",         "Binary input needs a size of 4 or 8 bytes.", "" },
+        { "bad byte order",       "Byte order must be l (little) or b (big).", "" },
+        { "command line only",    "The number of threads can only be set on the command line.", "" },
+        { "bad thread count",     "-j needs a number of threads.", "" },
+        { "command line only",    "Summary mode can only be set on the command line.", "" },
+        { "bad -x",               "Decimal input is turned off with -x0.", "" },
+        { "bad exponent range",   "Exponent range must be exp=LO:HI, with LO at most HI.", "" },
+        { "unknown filter",       "Unknown filter: ", "" },
+        { "command line only",    "The socket can only be set on the command line.", "" },
+        { "no socket path",       "--listen needs the path of a socket.", "" },
+        { "command line only",    "Statistics can only be turned on on the command line.", "" },
+        { "command line only",    "The error limit can only be set on the command line.", "" },
+        { "bad error limit",      "--errors needs a number, or all.", "" },
+        { "command line only",    "The cache can only be set on the command line.", "" },
+        { "bad cache size",       "--cache needs a number of values, at most 16777216.", "" },
+        { "command line only",    "A sweep can only be started on the command line.", "" },
+        { "bad sweep",            "--sweep needs LO:HI or LO:HI:STRIDE, LO and HI in hex.", "" },
+        { "sweep type",           "The ends of --sweep do not fit the type of -t.", "" },
+        { "reversed sweep",       "The start of --sweep is above its end.", "" },
+        { "command line only",    "Diff mode can only be set on the command line.", "" },
+        { "command line only",    "Dump input can only be selected on the command line.", "" },
+        { "unknown dump",         "Dumps must be xxd, od, hexdump or gdb.", "" },
+        { "command line only",    "The I/O backend can only be selected on the command line.", "" },
+        { "unknown io",           "--io must be auto, uring or sync.", "" },
+        { "files with --listen",  "Files can not be converted with --listen.", "" },
+        { "files with --sweep",   "Files can not be converted with --sweep.", "" },
+        { "dump with --listen",   "--dump can not be used with --listen.", "" },
+        { "dump with --diff",     "--dump can not be used with --diff.", "" },
+        { "diff file count",      "--diff needs two files.", "" },
+        { "bad input",            "Some of the input could not be converted.", "" },
+        { "incomplete value",     "", "" },
+    };
+
+    /*
+     * The last error, and the part of the token it is about. Set by the
+     * parsing functions instead of returning it, and cleared once reported.
+     * Each thread has its own, see ConvertParallel.
+     */
+    static thread_local ::Error          lastError = ::Error::None;
+    static thread_local std::string_view lastErrorDetail;
+
+    /* Sets lastError, and its detail. Returns false, for failing with it. */
+    static bool Fail(::Error error, std::string_view detail = std::string_view())
+    {
+        ::lastError       = error;
+        ::lastErrorDetail = detail;
+        return false;
+    }
+
+    // the conversion engine
+    using ieee754::Bits;
+    using ieee754::Half;
+    using ieee754::BFloat16;
+    using ieee754::Extended;
+    using ieee754::Quad;
+    using ieee754::FormatTraits;
+    using ieee754::FloatClass;
+    using ieee754::numFloatClasses;
+    using ieee754::floatClassNames;
+    using ieee754::IEEE754Float;
+    using ieee754::Filter;
+    using ieee754::IsFiltering;
+    using ieee754::Passes;
+    using ieee754::ClassCounts;
+    using ieee754::decimalExtraChars;
+    using ieee754::FormatDecimal;
+    using ieee754::FormatHex;
+    using ieee754::FormatUnsigned;
     
     /*
      * The type of input that the user has used.
@@ -57,511 +334,4969 @@ Return values:
         BadInput,
         Exit,
 
+        Half,
+        BFloat16,
         Float,
         Double,
+        Extended,
+        Quad,
 
         Help,
         Flag,
     };
 
-    /* Struct that keeps track of the global settings such as precision. */
-    struct
+    /*
+     * How values are written out.
+     */
+    enum class Format
+    {
+        Text, // decimal value and table (or just the value with -s)
+        Json, // one JSON object per line
+        Csv,  // one comma separated record per line, after a header
+    };
+
+    /*
+     * The layouts of hex dumps --dump reads.
+     */
+    enum class DumpFormat
+    {
+        None,    // not a dump
+        Xxd,     // xxd: "00000010: 3f80 0000  ?...", bytes in order
+        Od,      // od -x, -t x1/x2/x4/x8: "0000020 803f 0000", octal address,
+                 // little endian words
+        Hexdump, // hexdump, hexdump -C: "00000010  3f 80 00 00 |?...|"
+        Gdb,     // gdb's x/x: "0x601040 <a>: 0x3f800000 0x40490fdb"
+    };
+
+    /*
+     * How input that is not memory mapped is read, and output written.
+     */
+    enum class IoBackend
+    {
+        Auto,  // io_uring if the kernel has it, regular files are mapped
+        Uring, // io_uring for regular files too, if the kernel has it
+        Sync,  // read() and write()
+    };
+
+    /* Struct that keeps track of the settings such as precision. */
+    struct Settings
     {
         unsigned precision    = 2;
+        bool     roundTrip    = false; // shortest exact output, ignores precision
         bool     simpleOutput = false;
+        ::Format format       = ::Format::Text;
         bool     printHelp    = false;
-    } static currentSettings;
+        unsigned rawSize      = 0;     // bytes per raw value, 0 for hex text
+        bool     rawBigEndian = false; // byte order of raw values
+        unsigned threads      = 1;     // threads converting the input
+        ieee754::Type type    = ieee754::Type::Bad; // forced by -t, Bad to
+                                                    // go by the digits
+        bool     reverse      = false; // decimal input, hex output
+        bool     summary      = false; // count the values instead of printing them
+        ::Filter filter;
+        std::string_view listenPath; // --listen, serve on this socket
+        bool     stats        = false; // report counts and timings at exit
+        std::uint64_t maxErrors = std::numeric_limits<std::uint64_t>::max(); // --errors
+        std::size_t cacheSize = 0;     // --cache, rendered values kept per thread
+        std::string_view sweepFirst;   // --sweep, the hex of its ends, empty if
+        std::string_view sweepLast;    // not sweeping
+        std::uint64_t sweepStride = 1;
+        bool     diff         = false; // --diff, compare two inputs
+        ::DumpFormat dump     = ::DumpFormat::None; // --dump, raw values from a hex dump
+        ::IoBackend io        = ::IoBackend::Auto; // --io
+    };
+
+    // the most values --cache keeps.
+    constexpr std::size_t maxCacheSize = std::size_t(1) << 24;
+
+    /* The settings given on the command line, and after that, the settings
+       as of the last block of input read. */
+    static ::Settings currentSettings;
     
     /*
-     * Representation of an IEEE 754 float, 32 or 64 bit.
+     * The stages of converting a token that --stats times.
      */
-    template<typename T>
-    class IEEE754Float
+    enum class Stage
     {
-    private:
-        // utilizes the union trick to convert from hex to float.
-        union
-        {
-            std::uint64_t _uint;  // 64_t to ensure it is as large as a double.
-            T             _float; // float type
-        };
+        Tokenize,
+        Parse,  // GetInputType
+        Render, // the table, record or summary of a value
+        Write,  // OutputBuffer::WriteTo
+    };
+
+    constexpr unsigned numStages = 4;
+
+    constexpr const char *stageNames[numStages] =
+    {
+        "tokenizing", "parsing", "rendering", "writing",
+    };
 
-        static constexpr std::size_t maxSizeOfBinBuffer = (sizeof(_uint) * 8);
+    /*
+     * A timestamp for --stats: the time stamp counter where there is one,
+     * which costs a few cycles to read, nanoseconds elsewhere.
+     */
+    static inline std::uint64_t Ticks()
+    {
+#ifdef HEX_HAS_X86
+        return __builtin_ia32_rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+#ifdef HEX_HAS_X86
+    constexpr char ticksName[] = "cycles";
+#else
+    constexpr char ticksName[] = "ns";
+#endif
+
+    /*
+     * What --stats reports. Each thread counts into its own threadStats,
+     * without any locking, and adds them to totalStats with
+     * MergeThreadStats when it is done.
+     */
+    struct Stats
+    {
+        static constexpr unsigned numFormats = static_cast<unsigned>(::Input::Quad)
+            - static_cast<unsigned>(::Input::Half) + 1;
+
+        static constexpr unsigned numWidths = static_cast<unsigned>(hex::Width::Quad) + 1;
 
-        // string representing the _float's bits (1's or 0's).
-        using oCString = char[maxSizeOfBinBuffer + 1];
+        std::uint64_t tokens                   = 0;
+        std::uint64_t values[numFormats]       = {}; // by format, Half first
+        std::uint64_t invalid                  = 0;
+        // by the width their number of digits is read as, see hex::Width.
+        // Bad is for flags, and tokens of no width.
+        std::uint64_t invalidWidths[numWidths] = {};
+        std::uint64_t flags                    = 0;
+        std::uint64_t classes[numFloatClasses] = {};
+        std::uint64_t bytesIn                  = 0;
+        std::uint64_t bytesOut                 = 0;
+        std::uint64_t cacheHits                = 0;
+        std::uint64_t cacheMisses              = 0;
+        std::uint64_t ticks[numStages]         = {};
 
-        /* largely a wrapper around oCString type so it can be returned from
-           a function, as arrays cannot be returned in C, but structs can. */
-        struct outputString
+        /* Counts token, which GetInputType returned input for. */
+        void CountToken(::Input input, const std::string_view token)
         {
-            oCString str = { '\0' };  // string representation _uint (binary)
-            unsigned strSize = 0;     // how many bytes were actually used.
-            ::Input  inputType;
-            
-            char& operator[](unsigned index)
-            {
-                return str[index];
-            }
+            const std::size_t digits = hex::StripPrefix(token).size();
 
-            outputString operator=(outputString &ostr)
+            tokens++;
+            switch(input)
             {
-                std::strncpy(this->str, ostr.str, ostr.strSize);
-                this->strSize = ostr.strSize;
-                this->inputType = ostr.inputType;
-            }
-        };
-
-        outputString getBinary()
-        { 
-            char             *uintBuf;           /* char buffer
-                                                    representation of uint */
-            std::size_t       sizeofUintBuf = 0; // size of the buffer
-            outputString      binBuffer;         // return value
-
-            /* determine the size of uintBuf. this is necessary so doubles and
-               floats are not confused. */
-            switch(sizeof(_float))
-            {
-            case sizeof(double):
-                uintBuf = (char*) &_uint;
-                sizeofUintBuf = sizeof(double);
-                binBuffer.inputType = ::Input::Double;
+            case ::Input::BadInput:
+                invalid++;
+                invalidWidths[static_cast<unsigned>(
+                    ((token[0] == '-') || (digits == 0) || (digits > hex::maxScanDigits))
+                    ? hex::Width::Bad : hex::detail::WidthOf(digits))]++;
                 break;
 
-            case sizeof(float):
-                std::uint32_t newUint = static_cast<std::uint32_t>(_uint);
-                uintBuf = (char*) &newUint;
-                sizeofUintBuf = sizeof(float);
-                binBuffer.inputType = ::Input::Float;
+            case ::Input::Help:
+            case ::Input::Flag:
+                flags++;
                 break;
-            }
-
-            // loop through each byte of the uint
-            for(int j = sizeofUintBuf - 1; j >=  0; j--)
-            {
-                char curByte = uintBuf[j];
-                // get each bit from _uint bytes
-                for(int i = (sizeof(curByte) * 8) - 1; i >= 0; i--)
-                {
-                    char curChar;
 
-                    if(curByte & (1u << i))
-                    {
-                        curChar = '1';
-                    }
-                    else
-                    {
-                        curChar = '0';
-                    }
+            case ::Input::Exit:
+                break;
 
-                    binBuffer[binBuffer.strSize++] = curChar;
-                }
+            default:
+                values[static_cast<unsigned>(input) - static_cast<unsigned>(::Input::Half)]++;
+                break;
             }
-            
-            return binBuffer;
         }
 
-    public:
-        static IEEE754Float<T> HexStrToIEEEFloat(const std::string_view hex)
+        void Merge(const Stats &other)
         {
-            std::istringstream hexVal(hex.data());
-            std::uint64_t      inputAsHex;
-            IEEE754Float<T>    floatVal;
-
-            hexVal >> std::hex >> inputAsHex;
-            floatVal = inputAsHex;
-
-            return floatVal;
-        }
+            tokens   += other.tokens;
+            invalid  += other.invalid;
+            flags    += other.flags;
+            bytesIn  += other.bytesIn;
+            bytesOut += other.bytesOut;
+            cacheHits   += other.cacheHits;
+            cacheMisses += other.cacheMisses;
 
-        
-        IEEE754Float() = default;
-        
-        IEEE754Float(unsigned i)
-            : _uint(i)
-        {
-        }
+            for(unsigned f = 0; f < numFormats; f++)
+            {
+                values[f] += other.values[f];
+            }
 
-        IEEE754Float<T> operator=(std::uint64_t i)
-        {
-            _uint = i;
-            return *this;
-        }
+            for(unsigned w = 0; w < numWidths; w++)
+            {
+                invalidWidths[w] += other.invalidWidths[w];
+            }
 
-        const char *GetFloatClassification()
-        {
-            switch (std::fpclassify(_float))
+            for(unsigned c = 0; c < numFloatClasses; c++)
             {
-            case FP_INFINITE:
-                return "Infinity";
-            case FP_NAN:
-                return "NaN";
-            case FP_ZERO:
-                return "Zero";
-            case FP_SUBNORMAL:
-                return "Subnormal";
-            case FP_NORMAL:
-                return "Normal";
+                classes[c] += other.classes[c];
             }
 
-            return "";
+            for(unsigned s = 0; s < numStages; s++)
+            {
+                ticks[s] += other.ticks[s];
+            }
         }
 
-        const char *GetFloatSign()
+        /* Writes a count right aligned in a column, after a label. */
+        template<typename Out>
+        static void row(Out &out, const std::string_view label, std::uint64_t value)
         {
-            if (std::signbit(_float))
-                return "Negative";
-            else
-                return "Positive";
+            constexpr std::size_t labelWidth = 14;
+            constexpr std::size_t valueWidth = 16;
+
+            char  digits[24];
+            char *end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+
+            out.Write(label);
+            out.Fill(' ', labelWidth - std::min(labelWidth, label.size()));
+            out.Fill(' ', valueWidth - std::min<std::size_t>(valueWidth, end - digits));
+            out.Write(digits, end - digits);
+            out.Put('\n');
         }
-        
-        void PrintFormattedOutput()
-        {
-            outputString      os = getBinary();
-            unsigned          exponentSize;
-            unsigned          tableSize;
 
-            switch(os.inputType)
+        /* Writes the report of a run that took seconds to out, which has
+           Write, Put and Fill like OutputBuffer. */
+        template<typename Out>
+        void Print(Out &out, double seconds) const
+        {
+            constexpr const char *formatNames[numFormats] =
             {
-            case ::Input::Float:
-                exponentSize = 8;
-                tableSize = 45;
-                break;
+                "half", "bfloat16", "float", "double", "extended", "binary128",
+            };
+            constexpr const char *widthNames[numWidths] =
+            {
+                "  other", "  <= 8 digits", "  <= 16 digits", "  <= 20 digits", "  <= 32 digits",
+            };
 
-            case ::Input::Double:
-                exponentSize = 11;
-                tableSize = 77;
-                break;
+            std::uint64_t totalTicks = 0;
+            char          number[32];
 
-            default:
-                return; // TODO something has gone horribly wrong...
-                break;
+            for(std::uint64_t stageTicks : ticks)
+            {
+                totalTicks += stageTicks;
             }
-            
-            // prints the top and bottom of the table
-            auto printEnds = [&]()
-                                 {
-                                     std::cout << std::setw(tableSize)
-                                               << std::setfill('=')
-                                               << '\n';
-                                 };
 
-            char columnStr[] = "||";
-            char signStr[] = " Sign";
-            char expStr[] = "Exponent";
-
-            printEnds();
-            
-            std::cout << columnStr << signStr << columnStr << std::setfill(' ')
-                      << std::setw(exponentSize) << expStr << columnStr
-                      << std::setw(os.strSize - (exponentSize + 1))
-                      << "Mantissa" << columnStr
-                      << std::endl;
-            
-            std::cout << columnStr << std::setfill(' ')
-                      << std::setw((sizeof(signStr) - 1)
-                                   + (sizeof(columnStr) - 1)
-                                   - sizeof(columnStr) + 1)
-                      << os[0] << columnStr << std::flush;
-
-            // print the string's exponent [1, exponentsize]
-            for(unsigned i = 1; i <= exponentSize; i++)
+            out.Write("Statistics:\n");
+            row(out, "tokens", tokens);
+            for(unsigned f = 0; f < numFormats; f++)
+            {
+                if(values[f] != 0)
+                {
+                    row(out, formatNames[f], values[f]);
+                }
+            }
+            row(out, "invalid", invalid);
+            for(unsigned w = 0; w < numWidths; w++)
+            {
+                if(invalidWidths[w] != 0)
+                {
+                    row(out, widthNames[w], invalidWidths[w]);
+                }
+            }
+            row(out, "flags", flags);
+            for(unsigned c = 0; c < numFloatClasses; c++)
             {
-                std::cout << os[i];
+                row(out, floatClassNames[c], classes[c]);
             }
-
-            std::cout << columnStr;
-            // print the mantissa (fraction) (exponentsize, end]
-            for(unsigned i = exponentSize + 1; i < os.strSize; i++)
+            row(out, "bytes in", bytesIn);
+            row(out, "bytes out", bytesOut);
+            if((cacheHits + cacheMisses) != 0)
             {
-                std::cout << os[i];
+                row(out, "cache hits", cacheHits);
+                row(out, "cache misses", cacheMisses);
             }
 
-            std::cout << columnStr << std::endl;
-            printEnds();
-
+            out.Write("wall time     ");
+            out.Write(number, std::to_chars(number, number + sizeof(number), seconds,
+                                            std::chars_format::fixed, 6).ptr - number);
+            out.Write(" s, ");
+            out.Write(number, std::to_chars(number, number + sizeof(number),
+                                            (seconds > 0) ? (bytesIn / seconds / 1e6) : 0.0,
+                                            std::chars_format::fixed, 1).ptr - number);
+            out.Write(" MB/s in\n");
 
-            std::cout << "Class: " << GetFloatSign()
-                      << ' ' << GetFloatClassification()
-                      << '\n';
+            for(unsigned s = 0; s < numStages; s++)
+            {
+                out.Write(stageNames[s]);
+                out.Fill(' ', 14 - std::strlen(stageNames[s]));
+                out.Write(number, std::to_chars(number, number + sizeof(number),
+                                                (totalTicks != 0)
+                                                ? (100.0 * ticks[s] / totalTicks) : 0.0,
+                                                std::chars_format::fixed, 1).ptr - number);
+                out.Write("% (");
+                out.Write(number, std::to_chars(number, number + sizeof(number),
+                                                ticks[s]).ptr - number);
+                out.Put(' ');
+                out.Write(ticksName);
+                out.Write(")\n");
+            }
         }
+    };
 
-        T GetIEEEFloat()
-        {
-            return _float;
-        }
+    // one token in this many is timed by --stats.
+    constexpr unsigned tokenSampleEvery = 16;
 
-        ~IEEE754Float() = default;
+    static thread_local ::Stats threadStats;
+    static ::Stats              totalStats;
+    static std::mutex           totalStatsMutex;
 
-    };
+    /* Adds this thread's stats to totalStats, and starts them over. */
+    static void MergeThreadStats()
+    {
+        std::lock_guard<std::mutex> lock(::totalStatsMutex);
 
-    // aliases
-    using Float  = IEEE754Float<float>;
-    using Double = IEEE754Float<double>;
+        ::totalStats.Merge(::threadStats);
+        ::threadStats = ::Stats();
+    }
 
-    // TODO maybe do long double.
-    
     /*
-     * Determine if the input was a float or double. If it was neither, return BadInput.
+     * Charges the time between laps to the stages of a token, in this
+     * thread's stats. Time spent writing output in between is left out, as it
+     * is counted by WriteTo. Reading the clock costs about as much as parsing
+     * a token, so only one token in sampleEvery is timed, and its times are
+     * counted sampleEvery times. Does nothing unless on.
      */
-    static ::Input IsFloatOrDouble(const std::string_view str)
+    class StageTimer
     {
-        constexpr std::size_t floatSize = sizeof(float) * 2;
-        constexpr std::size_t doubleSize = sizeof(double) * 2;
-        ::Input               result = Input::BadInput;
+    private:
+        unsigned      _sampleEvery;
+        unsigned      _untilSample = 0; // tokens before the next timed one
+        std::uint64_t _last        = 0; // ticks at the last lap
+        std::uint64_t _written     = 0; // write ticks at the last lap
 
-        auto check = [&]() -> bool
+        void start()
         {
-            constexpr char beginHexAscii = 65; // A
-            constexpr char endHexAscii   = 70; // F
+            _last    = ::Ticks();
+            _written = ::threadStats.ticks[static_cast<unsigned>(::Stage::Write)];
+        }
 
-            for(char c : str)
+    public:
+        /* sampleEvery 0 is off. */
+        explicit StageTimer(unsigned sampleEvery)
+            : _sampleEvery(sampleEvery)
+        {
+            if(_sampleEvery != 0)
             {
-                // return false if char is not alphanumeric and in the Hex char range.
-                if(!std::isdigit(c))
-                {
-                    if(c < beginHexAscii
-                       || c > endHexAscii)
-                    {
-                        return false;
-                    }
-                }
+                start();
             }
+        }
 
-            return true;
-        };
-
-
-        switch(str.size())
+        void Lap(::Stage stage)
         {
-        case 0 ... floatSize:
-            if(check())
+            if((_sampleEvery != 0) && (_untilSample == 0))
             {
-                result = ::Input::Float;
-            }
-            break;
+                std::uint64_t now     = ::Ticks();
+                std::uint64_t written = ::threadStats.ticks[static_cast<unsigned>(::Stage::Write)];
 
-        case (floatSize + 1) ... doubleSize:
-            if(check())
-            {
-                result = ::Input::Double;
+                ::threadStats.ticks[static_cast<unsigned>(stage)]
+                    += ((now - _last) - (written - _written)) * _sampleEvery;
+                _last    = now;
+                _written = written;
             }
-            break;
         }
 
-        return result;
-    }
-
-    /* Interprets the user's flags, and sets the mode accordingly.
-       Returns false if it could not set the mode, true otherwise. */
-    static bool InterpretMode(const std::string_view input)
-    {
-        bool success = true;
-        
-        switch(input[1])
+        /* The last lap of a token. */
+        void EndToken(::Stage stage)
         {
-        case 's':
-        case 'S':
-            ::currentSettings.simpleOutput = true;
-            break;
-
-        case 'n':
-        case 'N':
-            ::currentSettings.simpleOutput = false;
-            break;
-
-        case 'h':
-        case 'H':
-            ::currentSettings.printHelp = true;
-            break;
-
-        case 'p':
-        case 'P': {
-            if(input.size() < 3)
-            {
-                ::lastErrorMsg = "Precision was not set with value.";
-                success = false;
-                break;
-            }
-
-            // get the rest of the input, and try to convert it to a string
-            std::string_view numString = input.substr(2, input.size());
-
-            try
-            {
-                ::currentSettings.precision =  std::stoi(numString.data());
-            }
-            catch(const std::invalid_argument &e)
+            if(_sampleEvery != 0)
             {
-                ::lastErrorMsg = "While trying to set the float precision: ";
-                ::lastErrorMsg += e.what();
+                Lap(stage);
+                _untilSample = (_untilSample == 0) ? (_sampleEvery - 1) : (_untilSample - 1);
+                if((_untilSample == 0) && (_sampleEvery != 1))
+                {
+                    start();
+                }
             }
         }
-            break;
-
-        default:
-            ::lastErrorMsg = "Unrecognized input: ";
-            ::lastErrorMsg += input.data();
-            success = false;
-            break;
-        }
-
-        return success;
-    }
-
+    };
 
     /*
-     * Gets program's interpretaion of the input that the user has put in.
+     * A small io_uring, driven with the raw system calls. Reads and writes
+     * are started without waiting for them, and their completions collected
+     * later, each with the tag it was started with, so the program can go on
+     * converting while the kernel does the I/O. Every operation is submitted
+     * as it is started, so the submission queue never fills up.
      */
-    static ::Input GetInputType(const std::string_view str)
+    class Uring
     {
-        ::Input input = ::Input::BadInput; // return value
+    private:
+        int            _fd         = -1;
+        std::uint32_t  _features   = 0;  // IORING_FEAT_ flags
+        void          *_sqRing     = MAP_FAILED;
+        void          *_cqRing     = MAP_FAILED; // the same mapping as _sqRing on
+                                                 // kernels that share it
+        io_uring_sqe  *_sqes       = nullptr;
+        std::size_t    _sqRingSize = 0;
+        std::size_t    _cqRingSize = 0;
+        unsigned       _entries    = 0;
+        unsigned      *_sqTail     = nullptr;
+        unsigned      *_sqMask     = nullptr;
+        unsigned      *_sqArray    = nullptr;
+        unsigned      *_cqHead     = nullptr;
+        unsigned      *_cqTail     = nullptr;
+        unsigned      *_cqMask     = nullptr;
+        io_uring_cqe  *_cqes       = nullptr;
 
-        // quit
-        if(str[0] == 'Q')
+        static unsigned *field(void *ring, std::uint32_t offset)
         {
-            input = ::Input::Exit;
+            return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset);
         }
-        // flag
-        else if(str[0] == '-')
+
+        int enter(unsigned toSubmit, unsigned minComplete, unsigned flags)
         {
-            if(str.size() < 2)
-            {
-                ::lastErrorMsg = "Not enough arguments for a flag.";
-            }
-            else if(InterpretMode(str))
+            int result;
+
+            do
             {
-                input = ::Input::Flag;
-            }
-        }
-        // a float or double
-        else
-        {
-            input = ::IsFloatOrDouble(str);
+                result = ::syscall(__NR_io_uring_enter, _fd, toSubmit, minComplete, flags,
+                                   nullptr, 0);
+            } while((result < 0) && (errno == EINTR));
+
+            return result;
         }
 
-        return input;
-    }
-    
-}
+        /* Queues and submits one operation. */
+        bool start(const io_uring_sqe &sqe)
+        {
+            const unsigned tail = *_sqTail;
+            const unsigned slot = tail & *_sqMask;
 
-/*
- * Runs main.
- */
-int main(const int argc, const char *argv[])
-{
-    bool        cont = true;
-    int         numFailedInputs = 0; /*  main return value (unless another error
-                                         occurs). number of user inputs that
-                                         could not be converted into floats.  */                             
-    std::string input;
+            _sqes[slot]    = sqe;
+            _sqArray[slot] = slot;
+            __atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+            return enter(1, 0, 0) == 1;
+        }
 
+    public:
+        Uring() = default;
+        Uring(const Uring&) = delete;
+        Uring &operator=(const Uring&) = delete;
 
-    // interpret command line arguments
-    if(argc != 1)
-    {
-        for(int i = 1; i < argc; i++)
+        ~Uring()
         {
-            if(!::InterpretMode(argv[i]))
+            if(_sqes)
             {
-                std::cerr << "Error: " << argv[i] << " is not recognized.\n";
-                numFailedInputs = -2;
-                cont = false;
+                ::munmap(_sqes, _entries * sizeof(io_uring_sqe));
             }
-            // exit immediately if help was called
-            else if(::currentSettings.printHelp)
+            if(_cqRing != _sqRing)
             {
-                cont = false;
-                std::cout << ::helpStr << '\n';
-                break;
+                ::munmap(_cqRing, _cqRingSize);
+            }
+            if(_sqRing != MAP_FAILED)
+            {
+                ::munmap(_sqRing, _sqRingSize);
+            }
+            if(_fd >= 0)
+            {
+                ::close(_fd);
             }
         }
-    }
-
-    // main loop
-    while(cont && (std::cin >> input))
-    {
-  
-        std::transform(input.begin(), input.end(), input.begin(),
-                       [](char c) -> char
-                           {
-                               if(std::islower(c))
-                               {
-                                   return std::toupper(c);
-                               }
 
-                               return c;
-                           });
-        // getting rid of the leading "0x" if it exists
-        std::string newInput = ((input[0] == '0') && (input[1] == 'X'))
-            ? input.substr(2, input.size()) : input;
-        
-        ::Input inputCode = ::GetInputType(newInput);
-        
-        switch(inputCode)
+        /* Sets up a ring for entries operations in flight. Returns false if
+           the kernel does not have io_uring, or does not allow it. */
+        bool Setup(unsigned entries)
         {
-        case ::Input::Double: {
-            ::Double d = ::Double::HexStrToIEEEFloat(input);
-            std::cout << std::setprecision(::currentSettings.precision)
-                      << d.GetIEEEFloat() << '\n';
-            // print the fancy output if the user has not turned it off
-            if(!::currentSettings.simpleOutput)
+            io_uring_params params = {};
+
+            _fd = ::syscall(__NR_io_uring_setup, entries, &params);
+            if(_fd < 0)
             {
-                d.PrintFormattedOutput();
+                return false;
             }
-            break;
 
-        }
-        case ::Input::Float: {
-            ::Float f = ::Float::HexStrToIEEEFloat(input);
-            std::cout << std::setprecision(::currentSettings.precision)
-                      << f.GetIEEEFloat() << '\n';
+            _features   = params.features;
+            _entries    = params.sq_entries;
+            _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            if(params.features & IORING_FEAT_SINGLE_MMAP)
+            {
+                _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+            }
 
-            if(!::currentSettings.simpleOutput)
+            _sqRing = ::mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+            if(_sqRing == MAP_FAILED)
             {
-                f.PrintFormattedOutput();
+                return false;
             }
-            break;
-        }
 
-        case ::Input::Flag:
-            // do nothing, handled elsewhere.
-            break;
-            
-        case ::Input::Help:
-            // print the helpstr and exit.
-            cont = false;
-            std::cout << ::helpStr << '\n';
-            break;
+            _cqRing = (params.features & IORING_FEAT_SINGLE_MMAP) ? _sqRing
+                : ::mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+            if(_cqRing == MAP_FAILED)
+            {
+                return false;
+            }
 
-        case ::Input::BadInput:
-            std::cerr << input << " is not recognized.\n";
-            // print the error message if one was set
-            if(!::lastErrorMsg.empty())
+            void *sqes = ::mmap(nullptr, _entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                                MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+            if(sqes == MAP_FAILED)
             {
-                std::cerr << ::lastErrorMsg << '\n';
+                return false;
             }
-            // clear the error message
-            ::lastErrorMsg.clear();
-            numFailedInputs++;
-            
-            break;
-            
-        case ::Input::Exit:
-            cont = false;
-            break;
+
+            _sqes    = static_cast<io_uring_sqe*>(sqes);
+            _sqTail  = field(_sqRing, params.sq_off.tail);
+            _sqMask  = field(_sqRing, params.sq_off.ring_mask);
+            _sqArray = field(_sqRing, params.sq_off.array);
+            _cqHead  = field(_cqRing, params.cq_off.head);
+            _cqTail  = field(_cqRing, params.cq_off.tail);
+            _cqMask  = field(_cqRing, params.cq_off.ring_mask);
+            _cqes    = reinterpret_cast<io_uring_cqe*>(static_cast<char*>(_cqRing)
+                                                       + params.cq_off.cqes);
+            return true;
         }
-    }
 
-    // checking if there was an error in input.
-    if(std::cin.bad())
+        /* Returns true if the kernel has feature, an IORING_FEAT_ flag. */
+        bool Has(std::uint32_t feature) const
+        {
+            return (_features & feature) != 0;
+        }
+
+        /* Starts reading (IORING_OP_READ) or writing (IORING_OP_WRITE) size
+           bytes of fd at offset, or at its position if offset is -1. */
+        bool Start(std::uint8_t opcode, int fd, void *buf, std::size_t size,
+                   std::uint64_t offset, std::uint64_t tag)
+        {
+            io_uring_sqe sqe = {};
+
+            sqe.opcode    = opcode;
+            sqe.fd        = fd;
+            sqe.addr      = reinterpret_cast<std::uintptr_t>(buf);
+            sqe.len       = static_cast<std::uint32_t>(size);
+            sqe.off       = offset;
+            sqe.user_data = tag;
+            return start(sqe);
+        }
+
+        /* Asks for the operation started with tag to stop. It still
+           completes, with -ECANCELED if it was stopped. */
+        bool Cancel(std::uint64_t tag, std::uint64_t cancelTag)
+        {
+            io_uring_sqe sqe = {};
+
+            sqe.opcode    = IORING_OP_ASYNC_CANCEL;
+            sqe.fd        = -1;
+            sqe.addr      = tag;
+            sqe.user_data = cancelTag;
+            return start(sqe);
+        }
+
+        /* Takes the next completion, if there is one. */
+        bool Peek(io_uring_cqe &cqe)
+        {
+            const unsigned head = *_cqHead;
+
+            if(head == __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE))
+            {
+                return false;
+            }
+
+            cqe = _cqes[head & *_cqMask];
+            __atomic_store_n(_cqHead, head + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+
+        /* Takes the next completion, waiting for one if there is none yet.
+           Returns false if the wait failed. */
+        bool Wait(io_uring_cqe &cqe)
+        {
+            while(!Peek(cqe))
+            {
+                if(enter(0, 1, IORING_ENTER_GETEVENTS) < 0)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    };
+
+    /*
+     * Writes buffers to a file descriptor through io_uring, in order, while
+     * the caller fills the next one. Only one write is in flight, so they
+     * land in order on pipes and files alike; the buffers after it wait
+     * their turn, and come back empty, keeping their memory, to be filled
+     * again.
+     */
+    class UringWriter
+    {
+    private:
+        static constexpr unsigned numBuffers = 4;
+
+        ::Uring     _ring;
+        int         _fd;
+        std::string _bufs[numBuffers];
+        unsigned    _first   = 0; // the buffer being written
+        unsigned    _queued  = 0; // buffers waiting, the first one included
+        std::size_t _written = 0; // bytes of the first buffer written so far
+        int         _error   = 0; // errno of a write that failed since the
+                                  // last call
+
+        void pop()
+        {
+            _bufs[_first].clear();
+            _first   = (_first + 1) % numBuffers;
+            _written = 0;
+            _queued--;
+        }
+
+        /* Starts writing the rest of the first buffer. Buffers that can not
+           be written are dropped, like WriteTo drops them. */
+        void startFirst()
+        {
+            while(_queued > 0)
+            {
+                std::string &buf = _bufs[_first];
+
+                if(_ring.Start(IORING_OP_WRITE, _fd, buf.data() + _written,
+                               buf.size() - _written, std::uint64_t(-1), 0))
+                {
+                    break;
+                }
+
+                fail(errno);
+                pop();
+            }
+        }
+
+        /* Takes the first buffer's write once it is done, waiting for it if
+           wait is set, and starts the next one. Returns false if it was not
+           done yet. */
+        bool finishFirst(bool wait)
+        {
+            const std::uint64_t start = ::Ticks();
+            io_uring_cqe        cqe   = {};
+
+            if(!_ring.Peek(cqe))
+            {
+                if(!wait)
+                {
+                    return false;
+                }
+                else if(!_ring.Wait(cqe))
+                {
+                    cqe.res = -EIO;
+                }
+            }
+
+            if(cqe.res >= 0)
+            {
+                _written                += cqe.res;
+                ::threadStats.bytesOut += cqe.res;
+            }
+            else if((cqe.res != -EINTR) && (cqe.res != -EAGAIN))
+            {
+                fail(-cqe.res);
+                _written = _bufs[_first].size();
+            }
+
+            if(_written == _bufs[_first].size())
+            {
+                pop();
+            }
+            startFirst();
+
+            if(wait)
+            {
+                ::threadStats.ticks[static_cast<unsigned>(::Stage::Write)] += ::Ticks() - start;
+            }
+            return true;
+        }
+
+        void fail(int error)
+        {
+            if(_error == 0)
+            {
+                _error = (error != 0) ? error : EIO;
+            }
+        }
+
+        int takeError()
+        {
+            int error = _error;
+
+            _error = 0;
+            return error;
+        }
+
+    public:
+        explicit UringWriter(int fd)
+            : _fd(fd)
+        {
+        }
+
+        ~UringWriter()
+        {
+            Drain();
+        }
+
+        /* Returns false if io_uring can not be used. Writes are at the
+           descriptor's position, which kernels before 5.6 do not have. */
+        bool Setup()
+        {
+            return _ring.Setup(numBuffers) && _ring.Has(IORING_FEAT_RW_CUR_POS);
+        }
+
+        /* Queues buf to be written after the buffers before it, and gives
+           back an empty buffer in its place. Returns the errno of a write
+           that failed since the last call, 0 if none did. */
+        int Write(std::string &buf)
+        {
+            if(!buf.empty())
+            {
+                while(_queued == numBuffers)
+                {
+                    finishFirst(true);
+                }
+
+                std::swap(buf, _bufs[(_first + _queued) % numBuffers]);
+                if(++_queued == 1)
+                {
+                    startFirst();
+                }
+            }
+
+            // move on to the next buffer if the last write is already done.
+            while((_queued > 0) && finishFirst(false))
+            {
+            }
+
+            return takeError();
+        }
+
+        /* Waits until everything queued is written. Returns the errno of a
+           write that failed since the last call, 0 if none did. */
+        int Drain()
+        {
+            while(_queued > 0)
+            {
+                finishFirst(true);
+            }
+
+            return takeError();
+        }
+    };
+
+    /*
+     * Collects output in memory and writes it to a file descriptor in large
+     * chunks. If the descriptor is a terminal, each value is written out as
+     * soon as it is finished so interactive use stays responsive. Without a
+     * descriptor the buffer only grows in memory. With WriteAsync, flushed
+     * output is written by io_uring while the next is collected.
+     */
+    class OutputBuffer
+    {
+    private:
+        static constexpr std::size_t flushSize = 1 << 16;
+
+        std::string _buf;
+        int         _fd;
+        bool        _interactive;
+        int         _error = 0; // errno of the first write that failed
+        std::unique_ptr<::UringWriter> _writer; // set by WriteAsync
+
+        /* Keeps the first write error. Returns false, for failing with it. */
+        bool fail(int error)
+        {
+            if((_error == 0) && (error != 0))
+            {
+                _error = error;
+            }
+
+            return error == 0;
+        }
+
+    public:
+        explicit OutputBuffer(int fd = -1)
+            : _fd(fd), _interactive((fd >= 0) && ::isatty(fd))
+        {
+            _buf.reserve(flushSize * 2);
+        }
+
+        OutputBuffer(const OutputBuffer&) = delete;
+        OutputBuffer &operator=(const OutputBuffer&) = delete;
+
+        ~OutputBuffer()
+        {
+            Flush();
+        }
+
+        void Write(const char *str, std::size_t size)
+        {
+            _buf.append(str, size);
+        }
+
+        void Write(const std::string_view str)
+        {
+            _buf.append(str);
+        }
+
+        void Put(char c)
+        {
+            _buf.push_back(c);
+        }
+
+        void Fill(char c, std::size_t count)
+        {
+            _buf.append(count, c);
+        }
+
+        /* Grows the buffer by size chars and returns a pointer to them, for
+           code that renders in place. */
+        char *Extend(std::size_t size)
+        {
+            std::size_t oldSize = _buf.size();
+
+            _buf.resize(oldSize + size);
+            return &_buf[oldSize];
+        }
+
+        /* Gives back chars obtained with Extend that were not used. */
+        void Shrink(std::size_t size)
+        {
+            _buf.resize(_buf.size() - size);
+        }
+
+        std::string_view View() const
+        {
+            return _buf;
+        }
+
+        /* Drops everything without writing it. */
+        void Clear()
+        {
+            _buf.clear();
+        }
+
+        /* Marks the end of one value's output. */
+        void EndValue()
+        {
+            if(_interactive || (_buf.size() >= flushSize))
+            {
+                Flush();
+            }
+        }
+
+        /* Writes everything out. Returns false on a write error. */
+        bool Flush()
+        {
+            if(_writer)
+            {
+                return fail(_writer->Write(_buf));
+            }
+
+            return (_fd < 0) || WriteTo(_fd);
+        }
+
+        /* Flush, and with WriteAsync, waits until all of it is written.
+           Returns false if any write has failed, see Error. */
+        bool Finish()
+        {
+            Flush();
+            if(_writer)
+            {
+                fail(_writer->Drain());
+            }
+
+            return _error == 0;
+        }
+
+        /* The errno of the first write that failed, 0 if none did. */
+        int Error() const
+        {
+            return _error;
+        }
+
+        /* Writes what is flushed through io_uring from now on. Returns false,
+           and goes on writing with write(), if the buffer writes to a
+           terminal or io_uring can not be set up. */
+        bool WriteAsync()
+        {
+            auto writer = std::make_unique<::UringWriter>(_fd);
+
+            if((_fd < 0) || _interactive || !writer->Setup())
+            {
+                return false;
+            }
+
+            Flush();
+            _writer = std::move(writer);
+            return true;
+        }
+
+        /* Writes other's output after this buffer's, and empties other. */
+        bool Send(::OutputBuffer &other)
+        {
+            if(_writer)
+            {
+                bool success = Flush();
+
+                return fail(_writer->Write(other._buf)) && success;
+            }
+            else if(_fd < 0)
+            {
+                _buf.append(other._buf);
+                other._buf.clear();
+                return true;
+            }
+
+            // this buffer's own output goes first.
+            bool success = Flush();
+
+            return (other.WriteTo(_fd) || fail(other._error)) && success;
+        }
+
+        /* Writes everything to fd instead of the buffer's own descriptor.
+           Returns false on a write error. */
+        bool WriteTo(int fd)
+        {
+            const std::uint64_t start   = ::Ticks();
+            std::size_t         written = 0;
+            bool                success = true;
+
+            while(written < _buf.size())
+            {
+                ssize_t result = ::write(fd, _buf.data() + written,
+                                         _buf.size() - written);
+                if(result < 0)
+                {
+                    if(errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    success = fail(errno);
+                    break;
+                }
+
+                written += result;
+            }
+
+            // once per flush, so this is always counted.
+            ::threadStats.bytesOut += written;
+            ::threadStats.ticks[static_cast<unsigned>(::Stage::Write)] += ::Ticks() - start;
+            _buf.clear();
+            return success;
+        }
+
+        int Fd() const
+        {
+            return _fd;
+        }
+    };
+
+    /*
+     * Appends value to out, see FormatDecimal.
+     */
+    template<typename T>
+    static void AppendDecimal(::OutputBuffer &out, T value, bool roundTrip,
+                              unsigned precision)
+    {
+        std::size_t size = precision + decimalExtraChars;
+        char       *dest = out.Extend(size);
+        char       *end  = ::FormatDecimal(dest, value, roundTrip, precision);
+
+        out.Shrink((dest + size) - end);
+    }
+
+    /*
+     * Returns true if str is name, ignoring the case of letters.
+     */
+    static bool EqualsNoCase(const std::string_view str, const std::string_view name)
+    {
+        if(str.size() != name.size())
+        {
+            return false;
+        }
+
+        for(std::size_t i = 0; i < str.size(); i++)
+        {
+            if((str[i] | 0x20) != (name[i] | 0x20))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    /*
+     * Parses the comma separated list of --only into filter: class names
+     * (as the table prints them), positive or negative, and exp=LO:HI for
+     * an inclusive range of unbiased exponents (either end may be left
+     * out, LO may not be above HI). Values must match one of the listed
+     * classes, one of the listed signs, and the range; a kind left out
+     * allows everything. "all" turns the filter off.
+     */
+    static bool ParseFilter(std::string_view spec, ::Filter &filter)
+    {
+        ::Filter result;
+        unsigned classes = 0;
+        unsigned signs   = 0;
+
+        while(!spec.empty())
+        {
+            std::size_t      comma = spec.find(',');
+            std::string_view item  = spec.substr(0, comma);
+            bool             found = false;
+
+            spec.remove_prefix((comma == std::string_view::npos) ? spec.size() : comma + 1);
+
+            for(unsigned c = 0; c < ::numFloatClasses; c++)
+            {
+                if(::EqualsNoCase(item, ::floatClassNames[c]))
+                {
+                    classes |= 1u << c;
+                    found    = true;
+                }
+            }
+
+            if(found)
+            {
+                continue;
+            }
+            else if(::EqualsNoCase(item, "positive"))
+            {
+                signs |= 1;
+            }
+            else if(::EqualsNoCase(item, "negative"))
+            {
+                signs |= 2;
+            }
+            else if(::EqualsNoCase(item, "all"))
+            {
+                classes = signs = 0;
+                result  = ::Filter();
+            }
+            else if(::EqualsNoCase(item.substr(0, 4), "exp="))
+            {
+                std::string_view range = item.substr(4);
+                std::size_t      colon = range.find(':');
+                std::string_view low   = range.substr(0, colon);
+                std::string_view high  = (colon == std::string_view::npos) ? low
+                    : range.substr(colon + 1);
+
+                auto parse = [](std::string_view number, int &exponent)
+                             {
+                                 auto [end, ec] = std::from_chars(number.data(),
+                                                                  number.data() + number.size(),
+                                                                  exponent);
+
+                                 return number.empty()
+                                     || ((ec == std::errc()) && (end == number.data() + number.size()));
+                             };
+
+                if(range.empty() || !parse(low, result.minExponent)
+                   || !parse(high, result.maxExponent)
+                   || (result.minExponent > result.maxExponent))
+                {
+                    return ::Fail(::Error::BadExponentRange);
+                }
+            }
+            else
+            {
+                return ::Fail(::Error::UnknownFilter, item);
+            }
+        }
+
+        if(classes != 0)
+        {
+            result.classes = classes;
+        }
+        if(signs != 0)
+        {
+            result.signs = signs;
+        }
+
+        filter = result;
+        return true;
+    }
+
+    /*
+     * Sets the size and byte order of raw values from spec, <4|8>[l|b] as
+     * given to -b.
+     */
+    static bool ParseRawSpec(::Settings &settings, const std::string_view spec)
+    {
+        if(spec.empty() || ((spec[0] != '4') && (spec[0] != '8'))
+           || (spec.size() > 2))
+        {
+            return ::Fail(::Error::BadRawSize);
+        }
+
+        bool bigEndian = false;
+
+        if(spec.size() == 2)
+        {
+            if((spec[1] == 'b') || (spec[1] == 'B'))
+            {
+                bigEndian = true;
+            }
+            else if((spec[1] != 'l') && (spec[1] != 'L'))
+            {
+                return ::Fail(::Error::BadByteOrder);
+            }
+        }
+
+        settings.rawSize      = spec[0] - '0';
+        settings.rawBigEndian = bigEndian;
+        return true;
+    }
+
+    /*
+     * Interprets a flag that starts with "--", which has a name and maybe a
+     * value after '='.
+     */
+    static bool InterpretLongFlag(::Settings &settings, const std::string_view input,
+                                  bool commandLine)
+    {
+        std::size_t      equals = input.find('=');
+        std::string_view name   = input.substr(2, equals - 2);
+        std::string_view value  = (equals == std::string_view::npos) ? std::string_view()
+            : input.substr(equals + 1);
+
+        if(name == "only")
+        {
+            return ::ParseFilter(value, settings.filter);
+        }
+        else if(name == "listen")
+        {
+            if(!commandLine)
+            {
+                return ::Fail(::Error::ListenCommandLine);
+            }
+            else if(value.empty())
+            {
+                return ::Fail(::Error::NoSocketPath);
+            }
+
+            // a program argument, so the view stays valid.
+            settings.listenPath = value;
+            return true;
+        }
+        else if(name == "errors")
+        {
+            std::uint64_t limit = 0;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(),
+                                             limit);
+
+            if(!commandLine)
+            {
+                return ::Fail(::Error::ErrorsCommandLine);
+            }
+            else if(value == "all")
+            {
+                limit = std::numeric_limits<std::uint64_t>::max();
+            }
+            else if(value.empty() || (ec != std::errc())
+                    || (end != value.data() + value.size()))
+            {
+                return ::Fail(::Error::BadErrorLimit);
+            }
+
+            settings.maxErrors = limit;
+            return true;
+        }
+        else if(name == "cache")
+        {
+            std::size_t size = 0;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(),
+                                             size);
+
+            if(!commandLine)
+            {
+                return ::Fail(::Error::CacheCommandLine);
+            }
+            else if(value.empty() || (ec != std::errc())
+                    || (end != value.data() + value.size()) || (size > ::maxCacheSize))
+            {
+                return ::Fail(::Error::BadCacheSize);
+            }
+
+            settings.cacheSize = size;
+            return true;
+        }
+        else if(name == "sweep")
+        {
+            std::size_t      colon  = value.find(':');
+            std::string_view first  = value.substr(0, colon);
+            std::string_view rest   = (colon == std::string_view::npos) ? std::string_view()
+                : value.substr(colon + 1);
+            std::size_t      colon2 = rest.find(':');
+            std::string_view last   = rest.substr(0, colon2);
+            std::string_view stride = (colon2 == std::string_view::npos) ? std::string_view()
+                : rest.substr(colon2 + 1);
+            std::uint64_t    step   = 1;
+
+            if(!commandLine)
+            {
+                return ::Fail(::Error::SweepCommandLine);
+            }
+            else if(!stride.empty())
+            {
+                auto [end, ec] = std::from_chars(stride.data(), stride.data() + stride.size(),
+                                                 step);
+
+                if((ec != std::errc()) || (end != stride.data() + stride.size()))
+                {
+                    step = 0;
+                }
+            }
+
+            // the type, and whether the ends fit it, is known once all
+            // flags are in, see GetSweepRange.
+            if((ieee754::ScanHex(first) == ieee754::Type::Bad)
+               || (ieee754::ScanHex(last) == ieee754::Type::Bad) || (step == 0)
+               || ((colon2 != std::string_view::npos) && stride.empty()))
+            {
+                return ::Fail(::Error::BadSweep);
+            }
+
+            // program arguments, so the views stay valid.
+            settings.sweepFirst  = first;
+            settings.sweepLast   = last;
+            settings.sweepStride = step;
+            return true;
+        }
+        else if(name == "dump")
+        {
+            constexpr std::pair<std::string_view, ::DumpFormat> formats[] =
+            {
+                { "xxd",     ::DumpFormat::Xxd },
+                { "od",      ::DumpFormat::Od },
+                { "hexdump", ::DumpFormat::Hexdump },
+                { "gdb",     ::DumpFormat::Gdb },
+            };
+
+            std::size_t      colon = value.find(':');
+            std::string_view kind  = value.substr(0, colon);
+
+            if(!commandLine)
+            {
+                return ::Fail(::Error::DumpCommandLine);
+            }
+
+            settings.dump = ::DumpFormat::None;
+            for(auto [formatName, format] : formats)
+            {
+                if(::EqualsNoCase(kind, formatName))
+                {
+                    settings.dump = format;
+                }
+            }
+
+            if(settings.dump == ::DumpFormat::None)
+            {
+                return ::Fail(::Error::UnknownDump);
+            }
+
+            // 4 byte little endian values unless told otherwise, like -b.
+            return ::ParseRawSpec(settings, (colon == std::string_view::npos) ? "4"
+                                  : value.substr(colon + 1));
+        }
+        else if(name == "io")
+        {
+            constexpr std::pair<std::string_view, ::IoBackend> backends[] =
+            {
+                { "auto",  ::IoBackend::Auto },
+                { "uring", ::IoBackend::Uring },
+                { "sync",  ::IoBackend::Sync },
+            };
+
+            if(!commandLine)
+            {
+                return ::Fail(::Error::IoCommandLine);
+            }
+
+            for(auto [backendName, backend] : backends)
+            {
+                if(::EqualsNoCase(value, backendName))
+                {
+                    settings.io = backend;
+                    return true;
+                }
+            }
+
+            return ::Fail(::Error::UnknownIo);
+        }
+        else if((name == "diff") && value.empty())
+        {
+            if(!commandLine)
+            {
+                return ::Fail(::Error::DiffCommandLine);
+            }
+
+            settings.diff = true;
+            return true;
+        }
+        else if((name == "stats") && value.empty())
+        {
+            if(!commandLine)
+            {
+                return ::Fail(::Error::StatsCommandLine);
+            }
+
+            settings.stats = true;
+            return true;
+        }
+
+        return ::Fail(::Error::UnknownFlag, input);
+    }
+
+    /*
+     * The input of a format.
+     */
+    static ::Input InputOf(ieee754::Type type)
+    {
+        switch(type)
+        {
+        case ieee754::Type::Half:     return ::Input::Half;
+        case ieee754::Type::BFloat16: return ::Input::BFloat16;
+        case ieee754::Type::Float:    return ::Input::Float;
+        case ieee754::Type::Double:   return ::Input::Double;
+        case ieee754::Type::Extended: return ::Input::Extended;
+        case ieee754::Type::Quad:     return ::Input::Quad;
+        default:                      return ::Input::BadInput;
+        }
+    }
+
+    /*
+     * Determine if the input was a float or double. If it was neither, return BadInput.
+     * See ieee754::ScanHex for the digits each format takes. If bits is
+     * given, it is set to the decoded value.
+     */
+    static ::Input IsFloatOrDouble(const std::string_view str,
+                                   ::Bits *bits = nullptr,
+                                   ieee754::Type forced = ieee754::Type::Bad)
+    {
+        return ::InputOf(ieee754::ScanHex(str, bits, forced));
+    }
+
+    /* Interprets the user's flags, and sets the mode accordingly.
+       Returns false if it could not set the mode, true otherwise.
+       commandLine is true for flags given as program arguments. */
+    static bool InterpretMode(::Settings &settings, const std::string_view input,
+                              bool commandLine = false)
+    {
+        bool success = true;
+        
+        switch(input[1])
+        {
+        case 's':
+        case 'S':
+            settings.simpleOutput = true;
+            break;
+
+        case 't':
+        case 'T': {
+            if(input.size() != 3)
+            {
+                ::Fail(::Error::BadType);
+                success = false;
+                break;
+            }
+
+            switch(input[2] | 0x20)
+            {
+            case 'a': settings.type = ieee754::Type::Bad;      break;
+            case 'h': settings.type = ieee754::Type::Half;     break;
+            case 'b': settings.type = ieee754::Type::BFloat16; break;
+            case 'f': settings.type = ieee754::Type::Float;    break;
+            case 'd': settings.type = ieee754::Type::Double;   break;
+            case 'x': settings.type = ieee754::Type::Extended; break;
+            case 'q': settings.type = ieee754::Type::Quad;     break;
+
+            default:
+                ::Fail(::Error::BadType);
+                success = false;
+                break;
+            }
+        }
+            break;
+
+        case 'o':
+        case 'O': {
+            std::string_view name = input.substr(2, input.size());
+
+            if(::EqualsNoCase(name, "text"))
+            {
+                settings.format = ::Format::Text;
+            }
+            else if(::EqualsNoCase(name, "json"))
+            {
+                settings.format = ::Format::Json;
+            }
+            else if(::EqualsNoCase(name, "csv"))
+            {
+                settings.format = ::Format::Csv;
+            }
+            else
+            {
+                ::Fail(::Error::BadFormat);
+                success = false;
+            }
+        }
+            break;
+
+        case 'b':
+        case 'B': {
+            // the rest of the input stream is binary, so this can only come
+            // before it.
+            if(!commandLine)
+            {
+                ::Fail(::Error::BinaryCommandLine);
+                success = false;
+                break;
+            }
+
+            success = ::ParseRawSpec(settings, input.substr(2, input.size()));
+        }
+            break;
+
+        case 'j':
+        case 'J': {
+            if(!commandLine)
+            {
+                ::Fail(::Error::ThreadsCommandLine);
+                success = false;
+                break;
+            }
+
+            std::string_view numString = input.substr(2, input.size());
+            unsigned         threads = 0;
+            auto [end, ec] = std::from_chars(numString.data(),
+                                             numString.data() + numString.size(),
+                                             threads);
+
+            if((ec != std::errc()) || (end != (numString.data() + numString.size())))
+            {
+                ::Fail(::Error::BadThreads);
+                success = false;
+                break;
+            }
+
+            // 0 means one per hardware thread
+            settings.threads = (threads != 0) ? threads
+                : std::max(1u, std::thread::hardware_concurrency());
+        }
+            break;
+
+        case 'r':
+        case 'R':
+            settings.roundTrip = true;
+            break;
+
+        case 'n':
+        case 'N':
+            settings.simpleOutput = false;
+            break;
+
+        case 'c':
+        case 'C':
+            if(!commandLine)
+            {
+                ::Fail(::Error::SummaryCommandLine);
+                success = false;
+                break;
+            }
+
+            settings.summary = true;
+            break;
+
+        case 'x':
+        case 'X':
+            if(input.size() == 2)
+            {
+                settings.reverse = true;
+            }
+            else if(input.substr(2) == "0")
+            {
+                settings.reverse = false;
+            }
+            else
+            {
+                ::Fail(::Error::BadReverse);
+                success = false;
+            }
+            break;
+
+        case 'h':
+        case 'H':
+            settings.printHelp = true;
+            break;
+
+        case 'p':
+        case 'P': {
+            if(input.size() < 3)
+            {
+                ::Fail(::Error::NoPrecision);
+                success = false;
+                break;
+            }
+
+            // get the rest of the input, and try to convert it to a number
+            std::string_view numString = input.substr(2, input.size());
+            unsigned         precision = 0;
+            auto [end, ec] = std::from_chars(numString.data(),
+                                             numString.data() + numString.size(),
+                                             precision);
+
+            if((ec != std::errc()) || (end != numString.data() + numString.size()))
+            {
+                ::Fail(::Error::BadPrecision, numString);
+                success = false;
+                break;
+            }
+
+            // the precision sizes the buffers values are formatted into.
+            settings.precision = std::min(precision, ieee754::maxDecimalPrecision);
+            settings.roundTrip = false;
+        }
+            break;
+
+        case '-':
+            success = ::InterpretLongFlag(settings, input, commandLine);
+            break;
+
+        default:
+            ::Fail(::Error::UnknownFlag, input);
+            success = false;
+            break;
+        }
+
+        return success;
+    }
+
+
+    /*
+     * Determine if the input is a decimal number (including inf and nan, with
+     * an optional sign) of settings' type, double if none was forced. If bits is
+     * given, it is set to the bits of the nearest value of that type.
+     */
+    static ::Input IsDecimal(const ::Settings &settings, std::string_view str,
+                             ::Bits *bits = nullptr)
+    {
+        return ::InputOf(ieee754::ParseDecimal(str, bits, settings.type));
+    }
+
+    /*
+     * Gets program's interpretaion of the input that the user has put in.
+     * For floats and doubles, bits is set to the value of the input.
+     */
+    static ::Input GetInputType(::Settings &settings, const std::string_view str,
+                                ::Bits *bits = nullptr)
+    {
+        ::Input input = ::Input::BadInput; // return value
+
+        if(str.empty())
+        {
+            ::Fail(::Error::Empty);
+        }
+        // quit
+        else if(str[0] == 'Q' || str[0] == 'q')
+        {
+            input = ::Input::Exit;
+        }
+        // flag, unless it is a negative number
+        else if((str[0] == '-')
+                && !(settings.reverse && ::IsDecimal(settings, str) != ::Input::BadInput))
+        {
+            if(str.size() < 2)
+            {
+                ::Fail(::Error::ShortFlag);
+            }
+            else if(InterpretMode(settings, str))
+            {
+                input = ::Input::Flag;
+            }
+        }
+        // a decimal number to find the bits of
+        else if(settings.reverse)
+        {
+            input = ::IsDecimal(settings, str, bits);
+        }
+        // a float or double
+        else
+        {
+            input = ::IsFloatOrDouble(str, bits, settings.type);
+        }
+
+        return input;
+    }
+
+    /*
+     * Returns true if c separates tokens (same set as std::isspace in the
+     * "C" locale).
+     */
+    static inline bool IsSpace(char c)
+    {
+        return (c == ' ') || ((c >= '\t') && (c <= '\r'));
+    }
+
+    /*
+     * Reads a file descriptor in large blocks. Every block handed out ends on
+     * a token boundary: a token cut off by the end of a read is carried over to
+     * the front of the next block, so tokens can be used as views into the
+     * buffer without copying them anywhere.
+     */
+    class BlockReader
+    {
+    private:
+        static constexpr std::size_t defaultBlockSize = 1 << 20;
+
+        std::vector<char> _buf;
+        int               _fd;
+        std::size_t       _carryBegin = 0; // unfinished token of the last block
+        std::size_t       _carrySize  = 0;
+        bool              _eof        = false;
+        bool              _bad        = false;
+
+    public:
+        // blocks are overwritten by the next read.
+        static constexpr bool stableBlocks = false;
+
+        explicit BlockReader(int fd, std::size_t blockSize = defaultBlockSize)
+            : _buf(blockSize), _fd(fd)
+        {
+        }
+
+        /* Returns the next block of whole tokens. The view is valid until the
+           next call. An empty view means the input is exhausted. */
+        std::string_view Next()
+        {
+            std::size_t size = _carrySize;
+
+            std::memmove(_buf.data(), _buf.data() + _carryBegin, _carrySize);
+            _carryBegin = _carrySize = 0;
+
+            while(!_eof)
+            {
+                // a single token filled the whole buffer, make room for more.
+                if(size == _buf.size())
+                {
+                    _buf.resize(_buf.size() * 2);
+                }
+
+                ssize_t bytesRead = ::read(_fd, _buf.data() + size,
+                                           _buf.size() - size);
+                if(bytesRead < 0)
+                {
+                    if(errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    _bad = _eof = true;
+                    break;
+                }
+                else if(bytesRead == 0)
+                {
+                    _eof = true;
+                    break;
+                }
+
+                std::size_t searchEnd = size;
+                size += bytesRead;
+
+                // cut the block after the last separator that was just read.
+                for(std::size_t i = size; i > searchEnd; i--)
+                {
+                    if(IsSpace(_buf[i - 1]))
+                    {
+                        _carryBegin = i;
+                        _carrySize  = size - i;
+                        return std::string_view(_buf.data(), i);
+                    }
+                }
+            }
+
+            // end of input, whatever is left is the last token.
+            return std::string_view(_buf.data(), size);
+        }
+
+        /* Returns the next block of binary input, a whole number of units of
+           unitSize bytes. Only the last block of the input may end with an
+           incomplete unit. An empty view means the input is exhausted. */
+        std::string_view NextUnits(std::size_t unitSize)
+        {
+            std::size_t size = _carrySize;
+
+            std::memmove(_buf.data(), _buf.data() + _carryBegin, _carrySize);
+            _carryBegin = _carrySize = 0;
+
+            while(!_eof)
+            {
+                ssize_t bytesRead = ::read(_fd, _buf.data() + size,
+                                           _buf.size() - size);
+                if(bytesRead < 0)
+                {
+                    if(errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    _bad = _eof = true;
+                    break;
+                }
+                else if(bytesRead == 0)
+                {
+                    _eof = true;
+                    break;
+                }
+
+                size += bytesRead;
+
+                if(size >= unitSize)
+                {
+                    std::size_t whole = size - (size % unitSize);
+
+                    _carryBegin = whole;
+                    _carrySize  = size - whole;
+                    return std::string_view(_buf.data(), whole);
+                }
+            }
+
+            return std::string_view(_buf.data(), size);
+        }
+
+        bool Bad() const
+        {
+            return _bad;
+        }
+    };
+
+    /*
+     * Reads a file descriptor through io_uring, with the interface of
+     * BlockReader. Reads are kept in flight ahead of the block being
+     * converted, so the device and the conversion work at the same time.
+     * Files that can be read at an offset have several reads in flight at
+     * once; pipes, terminals and sockets have one, started again as soon as
+     * the last one is taken. What the reads bring in is copied after the
+     * token carried over from the last block, which costs little next to
+     * converting it.
+     */
+    class UringReader
+    {
+    private:
+        static constexpr std::size_t readSize  = 1 << 18;
+        static constexpr std::size_t blockSize = 1 << 20; // finished reads are
+                                                          // taken up to this
+        static constexpr unsigned    numReads  = 4;
+        static constexpr std::uint64_t cancelTag = numReads;
+
+        struct Read
+        {
+            std::unique_ptr<char[]> buf;
+            std::uint64_t           offset = 0;
+            int                     result = 0;
+            bool                    done   = false;
+        };
+
+        ::Uring       _ring;
+        int           _fd;
+        bool          _seekable = false;
+        std::uint64_t _offset   = 0; // of the next read, if seekable
+        Read          _reads[numReads];
+        unsigned      _first    = 0; // the oldest read in flight
+        unsigned      _inFlight = 0;
+        std::string   _block;        // the last block, and the carry after it
+        std::size_t   _used     = 0; // bytes of _block handed out
+        bool          _eof      = false;
+        bool          _bad      = false;
+
+        bool startRead(unsigned i)
+        {
+            Read &read = _reads[i];
+
+            read.done = false;
+            return _ring.Start(IORING_OP_READ, _fd, read.buf.get(), readSize,
+                               _seekable ? read.offset : std::uint64_t(-1), i);
+        }
+
+        /* Starts reads into the free buffers, as many as the input allows. */
+        void start()
+        {
+            while(!_eof && (_inFlight < (_seekable ? numReads : 1)))
+            {
+                unsigned i    = (_first + _inFlight) % numReads;
+                Read    &read = _reads[i];
+
+                if(!read.buf)
+                {
+                    read.buf = std::make_unique<char[]>(readSize);
+                }
+
+                read.offset = _offset;
+                if(!startRead(i))
+                {
+                    _bad = _eof = true;
+                    break;
+                }
+
+                _offset += readSize;
+                _inFlight++;
+            }
+        }
+
+        /* Marks the reads that have completed as done, waiting until the
+           oldest one has if wait is set. Interrupted reads are started over,
+           unless they were cancelled. Returns whether the oldest is done. */
+        bool collect(bool wait, bool cancelled = false)
+        {
+            io_uring_cqe cqe;
+
+            while(!_reads[_first].done && (wait ? _ring.Wait(cqe) : _ring.Peek(cqe)))
+            {
+                if(cqe.user_data == cancelTag)
+                {
+                    continue;
+                }
+
+                Read &read = _reads[cqe.user_data];
+
+                read.result = cqe.res;
+                read.done   = cancelled
+                    || ((cqe.res != -EINTR) && (cqe.res != -EAGAIN))
+                    || !startRead(cqe.user_data);
+            }
+
+            return _reads[_first].done;
+        }
+
+        /* Stops the reads in flight, and waits until the kernel is done with
+           their buffers. */
+        void discard()
+        {
+            for(unsigned i = 0; i < _inFlight; i++)
+            {
+                unsigned slot = (_first + i) % numReads;
+
+                if(!_reads[slot].done)
+                {
+                    _ring.Cancel(slot, cancelTag);
+                }
+            }
+
+            for(; _inFlight > 0; _inFlight--)
+            {
+                if(!collect(true, true))
+                {
+                    // the buffers may still be written to, so they are kept.
+                    for(Read &read : _reads)
+                    {
+                        read.buf.release();
+                    }
+                    break;
+                }
+
+                _first = (_first + 1) % numReads;
+            }
+
+            _inFlight = 0;
+        }
+
+        /* Takes the oldest read, which is done. Returns what it read, empty
+           at the end of the input. The data stays valid until start. */
+        std::string_view take()
+        {
+            Read &read = _reads[_first];
+
+            _first = (_first + 1) % numReads;
+            _inFlight--;
+
+            if(read.result <= 0)
+            {
+                _bad = _bad || (read.result < 0);
+                _eof = true;
+                discard();
+                return std::string_view();
+            }
+            // the reads after a short one started past what it stopped at.
+            else if(_seekable && (static_cast<std::size_t>(read.result) < readSize))
+            {
+                discard();
+                _offset = read.offset + read.result;
+            }
+
+            return std::string_view(read.buf.get(), read.result);
+        }
+
+        /* The next block, cut after the last separator, or after the last
+           whole unit of unitSize bytes if unitSize is not 0. */
+        std::string_view next(std::size_t unitSize)
+        {
+            std::size_t cut = 0;
+
+            _block.erase(0, _used);
+            start();
+
+            while(_inFlight > 0)
+            {
+                // once there is a block, only take reads that are done.
+                if((cut != 0) && ((_block.size() >= blockSize) || !collect(false)))
+                {
+                    break;
+                }
+                else if(!collect(true))
+                {
+                    _bad = _eof = true;
+                    discard();
+                    break;
+                }
+
+                std::size_t searchEnd = _block.size();
+
+                _block.append(take());
+                start();
+
+                if(unitSize != 0)
+                {
+                    cut = std::max(cut, _block.size() - (_block.size() % unitSize));
+                }
+                else
+                {
+                    for(std::size_t i = _block.size(); i > searchEnd; i--)
+                    {
+                        if(::IsSpace(_block[i - 1]))
+                        {
+                            cut = i;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            // end of input, whatever is left is the last token.
+            if(_inFlight == 0)
+            {
+                cut = _block.size();
+            }
+
+            _used = cut;
+            return std::string_view(_block.data(), cut);
+        }
+
+    public:
+        // blocks are overwritten by the next read.
+        static constexpr bool stableBlocks = false;
+
+        explicit UringReader(int fd)
+            : _fd(fd)
+        {
+            off_t position = ::lseek(fd, 0, SEEK_CUR);
+
+            _seekable = (position >= 0);
+            _offset   = _seekable ? position : 0;
+        }
+
+        UringReader(const UringReader&) = delete;
+        UringReader &operator=(const UringReader&) = delete;
+
+        ~UringReader()
+        {
+            discard();
+        }
+
+        /* Returns false if io_uring can not be used. Streams are read at
+           their position, which kernels before 5.6 do not have. */
+        bool Setup()
+        {
+            return _ring.Setup(numReads + 1) && _ring.Has(IORING_FEAT_RW_CUR_POS);
+        }
+
+        /* Returns the next block of whole tokens. The view is valid until the
+           next call. An empty view means the input is exhausted. */
+        std::string_view Next()
+        {
+            return next(0);
+        }
+
+        /* Returns the next block of binary input, a whole number of units of
+           unitSize bytes. Only the last block of the input may end with an
+           incomplete unit. An empty view means the input is exhausted. */
+        std::string_view NextUnits(std::size_t unitSize)
+        {
+            return next(unitSize);
+        }
+
+        bool Bad() const
+        {
+            return _bad;
+        }
+    };
+
+    /*
+     * A regular file mapped into memory, handed out in blocks with the same
+     * interface as BlockReader. The page cache is the input buffer: blocks
+     * are views of the mapping, and stay valid as long as the MappedFile.
+     * The kernel is told to read ahead, and pages that have been converted
+     * are dropped again, so files larger than memory work as well.
+     */
+    class MappedFile
+    {
+    private:
+        static constexpr std::size_t blockSize   = 1 << 20;
+        static constexpr std::size_t releaseSize = 64 << 20; // drop pages in steps of this
+
+        const char *_data     = nullptr;
+        std::size_t _size     = 0;
+        std::size_t _pos      = 0; // start of the next block
+        std::size_t _released = 0; // everything before this was dropped
+
+        /* Moves to end, asking for the pages after it and dropping the ones
+           well behind it. */
+        std::string_view advance(std::size_t end)
+        {
+            std::string_view block(_data + _pos, end - _pos);
+            char            *base = const_cast<char*>(_data);
+
+            _pos = end;
+
+            if(_pos < _size)
+            {
+                std::size_t pageSize = ::sysconf(_SC_PAGESIZE);
+                std::size_t ahead    = _pos - (_pos % pageSize);
+
+                ::madvise(base + ahead, std::min(blockSize * 4, _size - ahead),
+                          MADV_WILLNEED);
+            }
+
+            // pages of a read only private mapping are just read back from
+            // the file if they are touched again, so this is always safe.
+            if((_pos - _released) >= (releaseSize * 2))
+            {
+                ::madvise(base + _released, releaseSize, MADV_DONTNEED);
+                _released += releaseSize;
+            }
+
+            return block;
+        }
+
+    public:
+        // blocks stay valid while later blocks are read.
+        static constexpr bool stableBlocks = true;
+
+        MappedFile() = default;
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile &operator=(const MappedFile&) = delete;
+
+        ~MappedFile()
+        {
+            if(_data)
+            {
+                ::munmap(const_cast<char*>(_data), _size);
+            }
+        }
+
+        /* Maps size bytes of fd, to be handed out from start on (the
+           file's position, for a shell's stdin that was partly read).
+           Returns false if it can not be mapped, in which case the file has
+           to be read some other way. */
+        bool Map(int fd, std::size_t size, std::size_t start = 0)
+        {
+            if(size <= start)
+            {
+                return true;
+            }
+
+            void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if(data == MAP_FAILED)
+            {
+                return false;
+            }
+
+            ::madvise(data, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+            ::madvise(data, size, MADV_HUGEPAGE);
+#endif
+
+            _data     = static_cast<const char*>(data);
+            _size     = size;
+            _pos      = start;
+            _released = start - (start % ::sysconf(_SC_PAGESIZE));
+            return true;
+        }
+
+        /* The offset in the file of the next block. */
+        std::size_t Position() const
+        {
+            return _pos;
+        }
+
+        /* Returns the next block of whole tokens, about blockSize long. An
+           empty view means the file is exhausted. */
+        std::string_view Next()
+        {
+            std::size_t end = std::min(_pos + blockSize, _size);
+
+            // finish the token the block would cut.
+            while((end != _size) && !::IsSpace(_data[end]))
+            {
+                end++;
+            }
+
+            return advance(end);
+        }
+
+        /* Returns the next block of whole units of unitSize bytes. Only the
+           last block may end with an incomplete unit. */
+        std::string_view NextUnits(std::size_t unitSize)
+        {
+            std::size_t size = blockSize - (blockSize % unitSize);
+
+            return advance(std::min(_pos + size, _size));
+        }
+
+        bool Bad() const
+        {
+            return false;
+        }
+    };
+
+    /*
+     * --dump: the text of a Reader read as a hex dump, handed out as the
+     * bytes it shows, with the same interface as BlockReader's raw input.
+     * Lines are decoded as they are needed, so a dump of any size goes
+     * through in one pass. Lines without any hex bytes (headers, gdb's other
+     * output) are skipped.
+     */
+    template<typename Reader>
+    class DumpReader
+    {
+    private:
+        static constexpr std::size_t blockSize = 1 << 16; // bytes per block, about
+
+        Reader            &_reader;
+        const ::DumpFormat _format;
+        std::string        _text;          // read, but not decoded yet
+        std::size_t        _textPos   = 0;
+        bool               _eof       = false;
+        std::string        _bytes;         // decoded, not handed out yet
+        std::size_t        _handedOut = 0; // of _bytes, by the last call
+        std::string        _line;          // decoded, to go after the repeats
+        // the last line with bytes, for "*" lines.
+        std::string        _previous;
+        std::uint64_t      _previousAddress = 0;
+        bool               _repeat          = false; // a "*" line came after it
+        std::uint64_t      _repeatsLeft     = 0;     // of it, still to go
+
+        /* Sets line to the next line of text. Returns false at the end. */
+        bool nextLine(std::string_view &line)
+        {
+            std::size_t end;
+
+            while((end = _text.find('\n', _textPos)) == std::string::npos)
+            {
+                std::string_view block = _eof ? std::string_view() : _reader.Next();
+
+                if(block.empty())
+                {
+                    _eof = true;
+                    // the last line may have no newline.
+                    if(_textPos == _text.size())
+                    {
+                        return false;
+                    }
+                    end = _text.size();
+                    break;
+                }
+
+                // the text is what is read, not the bytes it shows.
+                ::threadStats.bytesIn += block.size();
+                _text.erase(0, _textPos);
+                _textPos = 0;
+                _text.append(block);
+            }
+
+            line     = std::string_view(_text).substr(_textPos, end - _textPos);
+            _textPos = std::min(end + 1, _text.size());
+            return true;
+        }
+
+        /* Appends the bytes of a token of hex digits to bytes, in the order
+           they are in memory. Returns false if it is not whole bytes of hex
+           digits. */
+        bool appendToken(std::string_view token, std::string &bytes) const
+        {
+            const unsigned char *values = hex::detail::digitTable.values;
+            const std::size_t    start  = bytes.size();
+
+            if(_format == ::DumpFormat::Gdb)
+            {
+                token = hex::StripPrefix(token);
+            }
+
+            if(token.empty() || (token.size() % 2 != 0))
+            {
+                return false;
+            }
+
+            for(std::size_t i = 0; i < token.size(); i += 2)
+            {
+                unsigned high = values[static_cast<unsigned char>(token[i])];
+                unsigned low  = values[static_cast<unsigned char>(token[i + 1])];
+
+                if((high | low) > 0xF)
+                {
+                    bytes.resize(start);
+                    return false;
+                }
+                bytes.push_back(static_cast<char>((high << 4) | low));
+            }
+
+            // words are numbers, little endian in memory.
+            if(_format != ::DumpFormat::Xxd)
+            {
+                std::reverse(bytes.begin() + start, bytes.end());
+            }
+
+            return true;
+        }
+
+        /* Splits a line into its address (if it has one) and the part with
+           the bytes. */
+        void splitAddress(std::string_view line, std::string_view &address,
+                          std::string_view &data) const
+        {
+            std::size_t end;
+
+            if((_format == ::DumpFormat::Xxd) || (_format == ::DumpFormat::Gdb))
+            {
+                // up to the colon, after gdb's <symbol+offset>, which has
+                // colons of its own in C++ names, and <> in templates.
+                std::size_t from = 0;
+
+                if((_format == ::DumpFormat::Gdb)
+                   && ((from = line.find('<')) != std::string_view::npos))
+                {
+                    for(unsigned depth = 0; from < line.size(); from++)
+                    {
+                        depth += (line[from] == '<') ? 1 : (line[from] == '>') ? -1 : 0;
+                        if(depth == 0)
+                        {
+                            break;
+                        }
+                    }
+                }
+                end = line.find(':', from);
+                if(end == std::string_view::npos)
+                {
+                    address = data = std::string_view();
+                    return;
+                }
+                address = line.substr(0, end);
+                data    = line.substr(end + 1);
+                return;
+            }
+
+            end     = std::min(line.find_first_of(" \t"), line.size());
+            address = line.substr(0, end);
+            data    = line.substr(end);
+        }
+
+        /* Appends the bytes of the data part of a line to bytes. */
+        void decodeData(std::string_view data, std::string &bytes) const
+        {
+            std::size_t pos = 0;
+
+            for(;;)
+            {
+                std::size_t spaces = pos;
+
+                while((pos < data.size()) && ::IsSpace(data[pos]))
+                {
+                    pos++;
+                }
+                spaces = pos - spaces;
+
+                // xxd's ASCII column comes after two spaces, hexdump -C's
+                // between bars.
+                if((pos == data.size()) || (data[pos] == '|')
+                   || ((_format == ::DumpFormat::Xxd) && (spaces >= 2) && !bytes.empty()))
+                {
+                    return;
+                }
+
+                std::size_t end = pos;
+
+                while((end < data.size()) && !::IsSpace(data[end]))
+                {
+                    end++;
+                }
+
+                if(!appendToken(data.substr(pos, end - pos), bytes))
+                {
+                    return;
+                }
+                pos = end;
+            }
+        }
+
+        /* Reads an address: octal for od, hex for the others. */
+        bool parseAddress(std::string_view address, std::uint64_t &value) const
+        {
+            const int base = (_format == ::DumpFormat::Od) ? 8 : 16;
+
+            address = hex::StripPrefix(address.substr(0, address.find(' ')));
+
+            auto [end, ec] = std::from_chars(address.data(), address.data() + address.size(),
+                                             value, base);
+            return !address.empty() && (ec == std::errc())
+                && (end == address.data() + address.size());
+        }
+
+        /* Decodes lines until there are at least size bytes, or the text
+           ends. */
+        void fill(std::size_t size)
+        {
+            std::string_view text;
+
+            while(_bytes.size() < size)
+            {
+                if(_repeatsLeft != 0)
+                {
+                    _bytes.append(_previous);
+                    _repeatsLeft--;
+                    continue;
+                }
+                else if(!_line.empty())
+                {
+                    _bytes.append(_line);
+                    _previous.swap(_line);
+                    _line.clear();
+                    continue;
+                }
+                else if(!nextLine(text))
+                {
+                    return;
+                }
+
+                std::string_view address;
+                std::string_view data;
+                std::uint64_t    at = 0;
+
+                while(!text.empty() && ::IsSpace(text.front()))
+                {
+                    text.remove_prefix(1);
+                }
+                if(text.substr(0, 1) == "*")
+                {
+                    _repeat = true;
+                    continue;
+                }
+
+                splitAddress(text, address, data);
+                decodeData(data, _line);
+
+                // the lines "*" stands for end where this one starts, which
+                // is where od's last line (only an address) is.
+                if(_repeat && !_previous.empty() && parseAddress(address, at)
+                   && (at > _previousAddress + _previous.size()))
+                {
+                    _repeatsLeft = (at - _previousAddress) / _previous.size() - 1;
+                }
+                _repeat = false;
+
+                if(!_line.empty())
+                {
+                    _previousAddress = at;
+                    parseAddress(address, _previousAddress);
+                }
+            }
+        }
+
+    public:
+        // blocks are overwritten by the next call.
+        static constexpr bool stableBlocks = false;
+
+        DumpReader(Reader &reader, ::DumpFormat format)
+            : _reader(reader), _format(format)
+        {
+        }
+
+        /* Returns the next block of whole units of unitSize bytes. Only the
+           last block may end with an incomplete unit. */
+        std::string_view NextUnits(std::size_t unitSize)
+        {
+            _bytes.erase(0, _handedOut);
+            fill(blockSize);
+
+            std::size_t size = _bytes.size();
+
+            // fill stops short only at the end of the text.
+            if(size >= blockSize)
+            {
+                size -= size % unitSize;
+            }
+            _handedOut = size;
+
+            return std::string_view(_bytes.data(), size);
+        }
+
+        /* Dumps are always raw values, see NextUnits. */
+        std::string_view Next()
+        {
+            return NextUnits(1);
+        }
+
+        bool Bad() const
+        {
+            return _reader.Bad();
+        }
+    };
+
+    /*
+     * Splits a block into whitespace separated tokens.
+     */
+    class Tokenizer
+    {
+    private:
+        const char *_cur;
+        const char *_end;
+
+    public:
+        explicit Tokenizer(const std::string_view block)
+            : _cur(block.data()), _end(block.data() + block.size())
+        {
+        }
+
+        /* Sets token to the next token of the block. Returns false when there
+           are none left. */
+        bool Next(std::string_view &token)
+        {
+            while((_cur != _end) && IsSpace(*_cur))
+            {
+                _cur++;
+            }
+
+            if(_cur == _end)
+            {
+                return false;
+            }
+
+            const char *begin = _cur;
+
+            while((_cur != _end) && !IsSpace(*_cur))
+            {
+                _cur++;
+            }
+
+            token = std::string_view(begin, _cur - begin);
+            return true;
+        }
+    };
+
+
+    /*
+     * Where a block of input starts: the line (from 1), and the byte (from 0).
+     */
+    struct Position
+    {
+        std::uint64_t line = 1;
+        std::uint64_t byte = 0;
+
+        /* The position after block. */
+        Position After(const std::string_view block) const
+        {
+            return { line + std::count(block.begin(), block.end(), '\n'),
+                     byte + block.size() };
+        }
+    };
+
+    /*
+     * Reports the tokens that were not recognized, one line each with the
+     * token's position, to an output buffer. Nothing is allocated or thrown
+     * per error; only the first limit errors are written out, the rest are
+     * just counted, and the counts of each error are printed at the end.
+     */
+    class ErrorLog
+    {
+    private:
+        // tokens longer than this are cut short in messages.
+        static constexpr std::size_t maxTokenChars = 64;
+        // a line is rendered on the stack and written at once: a position,
+        // a token and a detail cut short, and the longest message fit.
+        static constexpr std::size_t maxLineChars  = 512;
+
+        ::OutputBuffer &_out;
+        std::uint64_t   _limit;
+        std::uint64_t   _shown             = 0;
+        std::uint64_t   _counts[numErrors] = {};
+
+        // the block being converted, and how many lines come before _cursor.
+        const char     *_block      = nullptr;
+        ::Position      _start;
+        const char     *_cursor     = nullptr;
+        std::uint64_t   _cursorLine = 1;
+
+        /* Appends str to a line ending at end, returns the new end. */
+        static char *append(char *end, const std::string_view str)
+        {
+            std::memcpy(end, str.data(), str.size());
+            return end + str.size();
+        }
+
+        static char *append(char *end, std::uint64_t value)
+        {
+            return std::to_chars(end, end + 20, value).ptr;
+        }
+
+        static void number(::OutputBuffer &out, std::uint64_t value)
+        {
+            char digits[20];
+
+            out.Write(digits, append(digits, value) - digits);
+        }
+
+        /* Counts error, returns true if it is to be written out. */
+        bool count(::Error error)
+        {
+            _counts[static_cast<unsigned>(error)]++;
+            if(_shown >= _limit)
+            {
+                return false;
+            }
+
+            _shown++;
+            return true;
+        }
+
+        /* Appends where at is in the input to a line ending at end. */
+        char *position(char *end, const char *at, bool withLine)
+        {
+            if(withLine)
+            {
+                _cursorLine += std::count(_cursor, at, '\n');
+                _cursor      = at;
+
+                end = append(end, "line ");
+                end = append(end, _cursorLine);
+                end = append(end, ", ");
+            }
+
+            end = append(end, "byte ");
+            end = append(end, _start.byte + (at - _block));
+            return append(end, ": ");
+        }
+
+    public:
+        /* limit is how many errors are written out, see --errors. */
+        ErrorLog(::OutputBuffer &out, std::uint64_t limit)
+            : _out(out), _limit(limit)
+        {
+        }
+
+        ErrorLog(const ErrorLog&) = delete;
+        ErrorLog &operator=(const ErrorLog&) = delete;
+
+        /* Tokens reported next are in block, which starts at start. */
+        void StartBlock(const std::string_view block, ::Position start)
+        {
+            _block      = block.data();
+            _start      = start;
+            _cursor     = block.data();
+            _cursorLine = start.line;
+        }
+
+        /* Reports token, of the current block, with the error (and detail)
+           it failed with. */
+        void Report(const std::string_view token, ::Error error,
+                    const std::string_view detail = std::string_view())
+        {
+            if(!count(error))
+            {
+                return;
+            }
+
+            const ::ErrorText &text = ::errorTexts[static_cast<unsigned>(error)];
+            char               line[maxLineChars];
+            char              *end = position(line, token.data(), true);
+
+            end = append(end, token.substr(0, maxTokenChars));
+            if(token.size() > maxTokenChars)
+            {
+                end = append(end, "...");
+            }
+            end = append(end, " is not recognized.");
+            if(*text.before != '\0')
+            {
+                end = append(end, " ");
+                end = append(end, text.before);
+                end = append(end, detail.substr(0, maxTokenChars));
+                end = append(end, text.after);
+            }
+            *end++ = '\n';
+
+            _out.Write(line, end - line);
+            _out.EndValue();
+        }
+
+        /* Reports the last rest bytes of raw input, of the current block,
+           which are not a whole value. */
+        void ReportIncomplete(const std::string_view rest)
+        {
+            if(!count(::Error::IncompleteValue))
+            {
+                return;
+            }
+
+            char  line[maxLineChars];
+            char *end = position(line, rest.data(), false);
+
+            end = append(end, "Input ended with ");
+            end = append(end, rest.size());
+            end = append(end, " bytes of an incomplete value.\n");
+
+            _out.Write(line, end - line);
+            _out.EndValue();
+        }
+
+        /* Adds the errors of other, which wrote text, after the ones of this
+           log. Only as many of its lines as the limit leaves are written. */
+        void Merge(const ErrorLog &other, const std::string_view text)
+        {
+            std::size_t end = 0;
+
+            for(std::uint64_t line = 0; (line < other._shown) && (_shown < _limit); line++)
+            {
+                end = text.find('\n', end) + 1;
+                _shown++;
+            }
+
+            _out.Write(text.substr(0, end));
+            for(unsigned e = 0; e < numErrors; e++)
+            {
+                _counts[e] += other._counts[e];
+            }
+        }
+
+        /* If errors were left out, writes how many of each there were. */
+        void PrintHidden()
+        {
+            std::uint64_t total = 0;
+
+            for(std::uint64_t count : _counts)
+            {
+                total += count;
+            }
+
+            if(total == _shown)
+            {
+                return;
+            }
+
+            number(_out, total - _shown);
+            _out.Write(" more errors were not shown. All errors:\n");
+            for(unsigned e = 0; e < numErrors; e++)
+            {
+                if(_counts[e] != 0)
+                {
+                    _out.Write("    ");
+                    number(_out, _counts[e]);
+                    _out.Put(' ');
+                    _out.Write(::errorTexts[e].name);
+                    _out.Put('\n');
+                }
+            }
+            _out.EndValue();
+        }
+
+        ::OutputBuffer &Out()
+        {
+            return _out;
+        }
+    };
+
+    /* The CSV header, fields in the same order as PrintRecord writes them. */
+    static constexpr char csvHeader[] = "hex,type,value,sign,exponent,mantissa,class\n";
+
+    /*
+     * Writes value as a JSON object or CSV record, depending on the
+     * settings' format. NaN and infinities are strings in JSON, as they are
+     * not JSON numbers. The record is rendered in place in one go.
+     */
+    template<typename T>
+    static void PrintRecord(::OutputBuffer &out, const ::Settings &settings,
+                            ::IEEE754Float<T> &value)
+    {
+        constexpr unsigned    hexDigits  = ::IEEE754Float<T>::numBits / 4;
+        constexpr std::size_t fieldChars = 200; // everything but the value
+        const bool            json       = (settings.format == ::Format::Json);
+        const bool            quoted     = json && !std::isfinite(value.GetIEEEFloat());
+        const std::size_t     size       = settings.precision + decimalExtraChars
+            + fieldChars;
+        char                 *dest       = out.Extend(size);
+        char                 *cur        = dest;
+
+        auto put = [&](const std::string_view str)
+                   {
+                       std::memcpy(cur, str.data(), str.size());
+                       cur += str.size();
+                   };
+
+        put(json ? "{\"hex\":\"" : "");
+        cur = ::FormatHex(cur, value.GetBits(), hexDigits);
+        put(json ? "\",\"type\":\"" : ",");
+        put(::IEEE754Float<T>::Traits::name);
+        put(json ? (quoted ? "\",\"value\":\"" : "\",\"value\":") : ",");
+        cur = ::FormatDecimal(cur, value, settings.roundTrip, settings.precision);
+        put(json ? (quoted ? "\",\"sign\":" : ",\"sign\":") : ",");
+        *cur++ = '0' + value.GetSignBit();
+        put(json ? ",\"exponent\":" : ",");
+        cur = std::to_chars(cur, cur + 20, value.GetExponentBits()).ptr;
+        put(json ? ",\"mantissa\":" : ",");
+        cur = ::FormatUnsigned(cur, value.GetMantissaBits());
+        put(json ? ",\"class\":\"" : ",");
+        put(value.GetFloatClassification());
+        put(json ? "\"}\n" : "\n");
+
+        out.Shrink((dest + size) - cur);
+    }
+
+    /*
+     * Renders the decimal value of bits as a T, or the bits themselves in
+     * hex when the input was decimal, and its table unless simple output was
+     * asked for.
+     */
+    template<typename T>
+    static void RenderValue(::OutputBuffer &out, const ::Settings &settings,
+                            ::Bits bits)
+    {
+        ::IEEE754Float<T> value;
+
+        value = bits;
+
+        switch(settings.format)
+        {
+        case ::Format::Text:
+            if(settings.reverse)
+            {
+                constexpr unsigned hexDigits = ::IEEE754Float<T>::numBits / 4;
+
+                ::FormatHex(out.Extend(hexDigits), value.GetBits(), hexDigits);
+            }
+            else
+            {
+                ::AppendDecimal(out, value, settings.roundTrip, settings.precision);
+            }
+            out.Put('\n');
+            // print the fancy output if the user has not turned it off
+            if(!settings.simpleOutput)
+            {
+                value.PrintFormattedOutput(out);
+            }
+            break;
+
+        case ::Format::Json:
+        case ::Format::Csv:
+            ::PrintRecord(out, settings, value);
+            break;
+        }
+    }
+
+    /*
+     * --cache: the output of values printed before, so that printing the
+     * same bits with the same settings again is one copy. A value can be in
+     * any of the 4 slots of its set, picked by a hash of its bits and mode;
+     * a new value takes an empty slot or the first one not hit since the last
+     * look for one (a second chance, which keeps the values that repeat).
+     * Each thread has its own, see threadCache, so there is no locking.
+     */
+    class RenderCache
+    {
+    private:
+        static constexpr unsigned ways = 4; // slots per set
+
+        struct Slot
+        {
+            ::Bits        bits = 0;
+            std::uint64_t mode = 0; // 0 for an empty slot
+            bool          hit  = false;
+            std::string   text;
+        };
+
+        std::vector<Slot> _slots; // a power of two of sets of them
+        unsigned          _shift = 63;
+
+        Slot *setOf(::Bits bits, std::uint64_t mode)
+        {
+            std::uint64_t hash = static_cast<std::uint64_t>(bits)
+                ^ static_cast<std::uint64_t>(bits >> 64) ^ mode;
+
+            // Fibonacci hashing: the high bits of the product are well mixed.
+            return &_slots[((hash * 0x9E3779B97F4A7C15u) >> _shift) * ways];
+        }
+
+    public:
+        /* What, besides the bits, a T's output depends on. Never 0. */
+        template<typename T>
+        static std::uint64_t ModeOf(const ::Settings &settings)
+        {
+            return settings.precision
+                | (std::uint64_t(settings.roundTrip) << 32)
+                | (std::uint64_t(settings.simpleOutput) << 33)
+                | (std::uint64_t(settings.reverse) << 34)
+                | (std::uint64_t(settings.format) << 35)
+                | (std::uint64_t(::IEEE754Float<T>::Traits::type) << 40)
+                | (std::uint64_t(1) << 63);
+        }
+
+        /* Makes room for size values (rounded up to a power of two),
+           dropping the ones kept. */
+        void Resize(std::size_t size)
+        {
+            unsigned bits = 1; // of the number of sets
+
+            while(((std::size_t(1) << bits) * ways) < size)
+            {
+                bits++;
+            }
+            _slots.assign((std::size_t(1) << bits) * ways, Slot());
+            _shift = 64 - bits;
+        }
+
+        std::size_t Size() const
+        {
+            return _slots.size();
+        }
+
+        /* Appends the output kept for bits and mode to out, if there is
+           any. Returns true if there was. */
+        bool Find(::OutputBuffer &out, ::Bits bits, std::uint64_t mode)
+        {
+            Slot *set = setOf(bits, mode);
+
+            for(unsigned way = 0; way < ways; way++)
+            {
+                if((set[way].mode == mode) && (set[way].bits == bits))
+                {
+                    set[way].hit = true;
+                    out.Write(set[way].text);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        /* Keeps text as the output of bits and mode, which is not kept. */
+        void Store(::Bits bits, std::uint64_t mode, const std::string_view text)
+        {
+            Slot    *set = setOf(bits, mode);
+            unsigned way = 0;
+
+            // every slot that was hit gets a second chance, so this ends.
+            while((set[way].mode != 0) && set[way].hit)
+            {
+                set[way].hit = false;
+                way          = (way + 1) % ways;
+            }
+
+            set[way].bits = bits;
+            set[way].mode = mode;
+            set[way].text.assign(text);
+        }
+    };
+
+    static thread_local ::RenderCache threadCache;
+
+    /*
+     * Prints the output of bits as a T, see RenderValue, from the thread's
+     * cache when settings have one.
+     */
+    template<typename T>
+    static void PrintValue(::OutputBuffer &out, const ::Settings &settings,
+                           ::Bits bits)
+    {
+        if(settings.cacheSize == 0)
+        {
+            ::RenderValue<T>(out, settings, bits);
+            out.EndValue();
+            return;
+        }
+
+        const std::uint64_t mode = ::RenderCache::ModeOf<T>(settings);
+
+        if(::threadCache.Size() < settings.cacheSize)
+        {
+            ::threadCache.Resize(settings.cacheSize);
+        }
+
+        if(::threadCache.Find(out, bits, mode))
+        {
+            if(settings.stats)
+            {
+                ::threadStats.cacheHits++;
+            }
+        }
+        else
+        {
+            const std::size_t start = out.View().size();
+
+            ::RenderValue<T>(out, settings, bits);
+            ::threadCache.Store(bits, mode, out.View().substr(start));
+            if(settings.stats)
+            {
+                ::threadStats.cacheMisses++;
+            }
+        }
+
+        out.EndValue();
+    }
+
+    /*
+     * What -c reports instead of the values: for each format, how many values
+     * it had of each sign and class, and of each biased exponent. Counts for
+     * a format are only allocated once one of its values is seen.
+     */
+    class Summary
+    {
+    private:
+        static constexpr unsigned numFormats = static_cast<unsigned>(ieee754::Type::Quad)
+            - static_cast<unsigned>(ieee754::Type::Half) + 1;
+        // copies of the exponent counts, so runs of values with the same
+        // exponent do not wait on each other's increments.
+        static constexpr unsigned numLanes   = 4; // unrolled in AddRaw
+        // values classified at a time.
+        static constexpr unsigned batchSize  = 1024;
+
+        struct Counts
+        {
+            ::ClassCounts              classes = {};
+            // numLanes copies of the counts per sign and exponent (the top
+            // bits of a value), one after the other
+            std::vector<std::uint64_t> tops;
+        };
+
+        Counts _counts[numFormats];
+
+        template<typename T>
+        Counts &countsOf()
+        {
+            using Traits = ::FormatTraits<T>;
+
+            Counts &counts = _counts[static_cast<unsigned>(Traits::type)
+                                     - static_cast<unsigned>(ieee754::Type::Half)];
+
+            if(counts.tops.empty())
+            {
+                counts.tops.resize(numLanes << (1 + Traits::exponentBits));
+            }
+
+            return counts;
+        }
+
+        /* Writes value right aligned in width chars. */
+        static void column(::OutputBuffer &out, std::int64_t value, unsigned width)
+        {
+            char  digits[24];
+            char *end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+
+            out.Fill(' ', width - std::min<unsigned>(width, end - digits));
+            out.Write(digits, end - digits);
+        }
+
+        template<typename T>
+        void print(::OutputBuffer &out) const
+        {
+            using Traits = ::FormatTraits<T>;
+
+            constexpr unsigned numExponents = 1u << Traits::exponentBits;
+            constexpr int      bias         = (numExponents / 2) - 1;
+            constexpr unsigned width        = 12;
+            const Counts      &counts       = _counts[static_cast<unsigned>(Traits::type)
+                                                      - static_cast<unsigned>(ieee754::Type::Half)];
+            std::uint64_t      total        = 0;
+
+            if(counts.tops.empty())
+            {
+                return;
+            }
+
+            for(const auto &bySign : counts.classes)
+            {
+                for(std::uint64_t count : bySign)
+                {
+                    total += count;
+                }
+            }
+
+            out.Write("Summary of ");
+            column(out, total, 0);
+            out.Put(' ');
+            out.Write(Traits::name);
+            out.Write(" values:\n");
+            out.Write("Class           Positive    Negative\n");
+            for(unsigned c = 0; c < ::numFloatClasses; c++)
+            {
+                out.Write(::floatClassNames[c]);
+                out.Fill(' ', 12 - std::strlen(::floatClassNames[c]));
+                column(out, counts.classes[0][c], width);
+                column(out, counts.classes[1][c], width);
+                out.Put('\n');
+            }
+
+            out.Write("Exponent    Unbiased    Positive    Negative\n");
+            for(unsigned exponent = 0; exponent < numExponents; exponent++)
+            {
+                std::uint64_t bySign[2] = {};
+
+                for(unsigned sign = 0; sign < 2; sign++)
+                {
+                    unsigned top = (sign * numExponents) + exponent;
+
+                    for(unsigned lane = 0; lane < numLanes; lane++)
+                    {
+                        bySign[sign] += counts.tops[(lane * 2 * numExponents) + top];
+                    }
+                }
+
+                if((bySign[0] + bySign[1]) != 0)
+                {
+                    // subnormals have the smallest normal exponent.
+                    column(out, exponent, 8);
+                    column(out, std::max<int>(exponent, 1) - bias, width);
+                    column(out, bySign[0], width);
+                    column(out, bySign[1], width);
+                    out.Put('\n');
+                }
+            }
+        }
+
+    public:
+        /* Counts one value of type T. */
+        template<typename T>
+        void Add(::Bits bits)
+        {
+            ::IEEE754Float<T> value;
+            Counts           &counts = countsOf<T>();
+
+            value = bits;
+            counts.classes[value.GetSignBit()][static_cast<unsigned>(value.GetFloatClass())]++;
+            counts.tops[value.GetBits() >> ::IEEE754Float<T>::mantissaBits]++;
+        }
+
+        /* Counts count raw UInt values of type T at data, byte swapped if
+           swap. */
+        template<typename T, typename UInt>
+        void AddRaw(const char *data, std::size_t count, bool swap)
+        {
+            Counts       &counts = countsOf<T>();
+            std::uint32_t tops[batchSize];
+
+            for(std::size_t done = 0; done < count; done += batchSize)
+            {
+                std::size_t  size  = std::min<std::size_t>(batchSize, count - done);
+                const char  *batch = data + (done * sizeof(UInt));
+
+                ieee754::ClassifyRaw<T, UInt>(batch, size, swap, tops, counts.classes);
+
+                std::uint64_t    *lane0   = counts.tops.data();
+                const std::size_t numTops = counts.tops.size() / numLanes;
+                std::size_t       i       = 0;
+
+                for(; (i + numLanes) <= size; i += numLanes)
+                {
+                    lane0[tops[i]]++;
+                    lane0[numTops + tops[i + 1]]++;
+                    lane0[(2 * numTops) + tops[i + 2]]++;
+                    lane0[(3 * numTops) + tops[i + 3]]++;
+                }
+
+                for(; i < size; i++)
+                {
+                    lane0[tops[i]]++;
+                }
+            }
+        }
+
+        /* Adds the counts of other to these. */
+        void Merge(const Summary &other)
+        {
+            for(unsigned f = 0; f < numFormats; f++)
+            {
+                const Counts &from = other._counts[f];
+                Counts       &to   = _counts[f];
+
+                if(from.tops.empty())
+                {
+                    continue;
+                }
+                else if(to.tops.empty())
+                {
+                    to = from;
+                    continue;
+                }
+
+                for(unsigned sign = 0; sign < 2; sign++)
+                {
+                    for(unsigned c = 0; c < ::numFloatClasses; c++)
+                    {
+                        to.classes[sign][c] += from.classes[sign][c];
+                    }
+                }
+
+                for(std::size_t i = 0; i < to.tops.size(); i++)
+                {
+                    to.tops[i] += from.tops[i];
+                }
+            }
+        }
+
+        /* Writes the report of every format that had values. */
+        void Print(::OutputBuffer &out) const
+        {
+            print<::Half>(out);
+            print<::BFloat16>(out);
+            print<float>(out);
+            print<double>(out);
+            print<::Extended>(out);
+            print<::Quad>(out);
+        }
+    };
+
+    /*
+     * How converting a block went.
+     */
+    struct BlockResult
+    {
+        int        numFailedInputs = 0;
+        bool       stop            = false; // the user quit
+        ::Summary  summary;                 // the values, with -c
+    };
+
+    /*
+     * Prints the value of bits as a T, or with -c, counts it in result's
+     * summary. Values the filter drops are not formatted at all.
+     */
+    template<typename T>
+    static void OutputValue(::OutputBuffer &out, const ::Settings &settings,
+                            ::Bits bits, ::BlockResult &result)
+    {
+        ::IEEE754Float<T> value;
+
+        value = bits;
+        if(settings.stats)
+        {
+            ::threadStats.classes[static_cast<unsigned>(value.GetFloatClass())]++;
+        }
+
+        if(!::Passes(settings.filter, value))
+        {
+            return;
+        }
+        else if(settings.summary)
+        {
+            result.summary.Add<T>(bits);
+        }
+        else
+        {
+            ::PrintValue<T>(out, settings, bits);
+        }
+    }
+
+    /*
+     * Converts the hex tokens of a block of whole tokens, applying its flags
+     * to settings along the way. Values go to out, tokens that are not
+     * recognized to errors, which must have been started on block.
+     */
+    static ::BlockResult ConvertTextBlock(::Settings &settings,
+                                          const std::string_view block,
+                                          ::OutputBuffer &out, ::ErrorLog &errors)
+    {
+        ::BlockResult    result;
+        ::Tokenizer      tokens(block);
+        std::string_view input;
+        ::StageTimer     timer(settings.stats ? ::tokenSampleEvery : 0);
+
+        while(!result.stop && tokens.Next(input))
+        {
+            timer.Lap(::Stage::Tokenize);
+
+            ::Bits   bits;
+            ::Format oldFormat = settings.format;
+            ::Input  inputCode = ::GetInputType(settings, input, &bits);
+
+            timer.Lap(::Stage::Parse);
+            if(settings.stats)
+            {
+                ::threadStats.CountToken(inputCode, input);
+            }
+
+            switch(inputCode)
+            {
+            case ::Input::Half:
+                ::OutputValue<::Half>(out, settings, bits, result);
+                break;
+
+            case ::Input::BFloat16:
+                ::OutputValue<::BFloat16>(out, settings, bits, result);
+                break;
+
+            case ::Input::Double:
+                ::OutputValue<double>(out, settings, bits, result);
+                break;
+
+            case ::Input::Float:
+                ::OutputValue<float>(out, settings, bits, result);
+                break;
+
+            case ::Input::Extended:
+                ::OutputValue<::Extended>(out, settings, bits, result);
+                break;
+
+            case ::Input::Quad:
+                ::OutputValue<::Quad>(out, settings, bits, result);
+                break;
+
+            case ::Input::Flag:
+                // switching to CSV starts a new table.
+                if((settings.format == ::Format::Csv) && (oldFormat != ::Format::Csv)
+                   && !settings.summary)
+                {
+                    out.Write(::csvHeader);
+                }
+                break;
+
+            case ::Input::Help:
+                // print the helpstr and exit.
+                result.stop = true;
+                out.Write(::helpStr);
+                out.Put('\n');
+                break;
+
+            case ::Input::BadInput:
+                // keep stdout and stderr in order on a terminal
+                out.EndValue();
+                if(::lastError == ::Error::None)
+                {
+                    errors.Report(input, ::Error::NotAValue);
+                }
+                else
+                {
+                    errors.Report(input, ::lastError, ::lastErrorDetail);
+                    ::lastError = ::Error::None;
+                }
+                result.numFailedInputs++;
+
+                break;
+
+            case ::Input::Exit:
+                result.stop = true;
+                break;
+            }
+
+            timer.EndToken(::Stage::Render);
+        }
+
+        return result;
+    }
+
+    /*
+     * Returns true if the raw input's byte order is not the machine's.
+     */
+    static inline bool RawNeedsSwap(const ::Settings &settings)
+    {
+        constexpr bool hostBigEndian = (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__);
+
+        return settings.rawBigEndian != hostBigEndian;
+    }
+
+    /*
+     * Reverses the byte order of value if the raw input's byte order is not
+     * the machine's.
+     */
+    template<typename UInt>
+    static inline UInt FromRawOrder(const ::Settings &settings, UInt value)
+    {
+        if(!::RawNeedsSwap(settings))
+        {
+            return value;
+        }
+
+        if constexpr(sizeof(UInt) == sizeof(std::uint64_t))
+        {
+            return __builtin_bswap64(value);
+        }
+        else
+        {
+            return __builtin_bswap32(value);
+        }
+    }
+
+    /*
+     * Prints every sizeof(UInt) byte value of block as a T, or with -c, counts
+     * them in result's summary.
+     */
+    template<typename T, typename UInt>
+    static void ConvertRawValues(const ::Settings &settings,
+                                 const std::string_view block, ::OutputBuffer &out,
+                                 ::BlockResult &result)
+    {
+        if(settings.stats)
+        {
+            ::threadStats.values[static_cast<unsigned>(FormatTraits<T>::type)
+                                 - static_cast<unsigned>(ieee754::Type::Half)]
+                += block.size() / sizeof(UInt);
+        }
+
+        // the classes for --stats come from OutputValue.
+        if(settings.summary && !::IsFiltering(settings.filter) && !settings.stats)
+        {
+            result.summary.AddRaw<T, UInt>(block.data(), block.size() / sizeof(UInt),
+                                           ::RawNeedsSwap(settings));
+            return;
+        }
+
+        for(std::size_t i = 0; (i + sizeof(UInt)) <= block.size(); i += sizeof(UInt))
+        {
+            UInt raw;
+
+            std::memcpy(&raw, block.data() + i, sizeof(raw));
+            ::OutputValue<T>(out, settings, ::FromRawOrder(settings, raw), result);
+        }
+    }
+
+    /*
+     * Converts a block of raw IEEE 754 values of settings.rawSize bytes. A
+     * block ending in the middle of a value counts as one failed input.
+     */
+    static ::BlockResult ConvertRawBlock(const ::Settings &settings,
+                                         const std::string_view block,
+                                         ::OutputBuffer &out, ::ErrorLog &errors)
+    {
+        ::BlockResult result;
+        ::StageTimer  timer(settings.stats ? 1 : 0);
+
+        if(settings.rawSize == sizeof(double))
+        {
+            ::ConvertRawValues<double, std::uint64_t>(settings, block, out, result);
+        }
+        else
+        {
+            ::ConvertRawValues<float, std::uint32_t>(settings, block, out, result);
+        }
+        timer.Lap(::Stage::Render);
+
+        // only the last block of the input can have a partial value.
+        if(std::size_t leftover = block.size() % settings.rawSize)
+        {
+            out.EndValue();
+            errors.ReportIncomplete(block.substr(block.size() - leftover));
+            result.numFailedInputs++;
+        }
+
+        return result;
+    }
+
+    /*
+     * Reads the next block of input, in the input format of settings.
+     */
+    template<typename Reader>
+    static std::string_view NextBlock(Reader &reader, const ::Settings &settings)
+    {
+        return (settings.rawSize != 0) ? reader.NextUnits(settings.rawSize)
+            : reader.Next();
+    }
+
+    /*
+     * Converts a block read by NextBlock. errors must have been started on
+     * it.
+     */
+    static ::BlockResult ConvertBlock(::Settings &settings,
+                                      const std::string_view block,
+                                      ::OutputBuffer &out, ::ErrorLog &errors)
+    {
+        // a dump's text is counted as DumpReader reads it.
+        if(settings.dump == ::DumpFormat::None)
+        {
+            ::threadStats.bytesIn += block.size();
+        }
+
+        return (settings.rawSize != 0)
+            ? ::ConvertRawBlock(settings, block, out, errors)
+            : ::ConvertTextBlock(settings, block, out, errors);
+    }
+
+    /*
+     * Converts reader's input until it ends or the user quits. Returns the
+     * number of inputs that were not recognized, and whether the user quit.
+     */
+    template<typename Reader>
+    static ::BlockResult Convert(Reader &reader, ::OutputBuffer &out,
+                                 ::ErrorLog &errors)
+    {
+        ::BlockResult total;
+        ::Position    position;
+
+        while(!total.stop)
+        {
+            std::string_view block = ::NextBlock(reader, ::currentSettings);
+
+            if(block.empty())
+            {
+                break;
+            }
+
+            errors.StartBlock(block, position);
+            position = position.After(block);
+
+            ::BlockResult result = ::ConvertBlock(::currentSettings, block,
+                                                  out, errors);
+            total.numFailedInputs += result.numFailedInputs;
+            total.stop             = result.stop;
+            total.summary.Merge(result.summary);
+
+            // do not hold output back while waiting for more input.
+            out.Flush();
+            errors.Out().Flush();
+        }
+
+        return total;
+    }
+
+    /*
+     * A fixed set of threads running queued jobs in the order they came in.
+     */
+    class WorkerPool
+    {
+    private:
+        std::vector<std::thread>          _threads;
+        std::deque<std::function<void()>> _jobs;
+        std::mutex                        _mutex;
+        std::condition_variable           _cond;
+        bool                              _done = false;
+
+        void work()
+        {
+            for(;;)
+            {
+                std::function<void()> job;
+
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+
+                    _cond.wait(lock, [this]() { return _done || !_jobs.empty(); });
+                    if(_jobs.empty())
+                    {
+                        ::MergeThreadStats();
+                        return;
+                    }
+
+                    job = std::move(_jobs.front());
+                    _jobs.pop_front();
+                }
+
+                job();
+            }
+        }
+
+    public:
+        explicit WorkerPool(unsigned numThreads)
+        {
+            for(unsigned i = 0; i < numThreads; i++)
+            {
+                _threads.emplace_back([this]() { work(); });
+            }
+        }
+
+        /* Runs the jobs left in the queue, then stops the threads. */
+        ~WorkerPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _done = true;
+            }
+
+            _cond.notify_all();
+            for(std::thread &thread : _threads)
+            {
+                thread.join();
+            }
+        }
+
+        void Submit(std::function<void()> job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _jobs.push_back(std::move(job));
+            }
+
+            _cond.notify_one();
+        }
+    };
+
+    /*
+     * A block of input converted by a worker thread. It has its own copy of
+     * the settings as of its first token, and its own output, so chunks can
+     * be converted in any order and written out in input order.
+     */
+    struct Chunk
+    {
+        std::string        storage; // copy of the input, if the reader reuses its buffer
+        std::string_view   input;
+        ::Settings         settings;
+        ::OutputBuffer     out;
+        ::OutputBuffer     err;
+        ::ErrorLog         errors;
+        ::BlockResult      result;
+        std::promise<void> done;
+
+        explicit Chunk(std::uint64_t maxErrors)
+            : errors(err, maxErrors)
+        {
+        }
+    };
+
+    /*
+     * Applies the flags of a block of whole tokens to settings, so the next
+     * block can start with the right settings before this one is converted.
+     * Only the first char of each token is looked at, with memchr, which is
+     * far cheaper than converting the block. Returns true if the block has a
+     * quit token.
+     */
+    static bool ScanControlTokens(::Settings &settings, const std::string_view block)
+    {
+        const char *begin = block.data();
+        const char *end   = begin + block.size();
+
+        auto isTokenStart = [&](const char *c)
+                            {
+                                return (c == begin) || ::IsSpace(c[-1]);
+                            };
+
+        for(const char *dash = begin;
+            (dash = static_cast<const char*>(std::memchr(dash, '-', end - dash)));
+            dash++)
+        {
+            if(isTokenStart(dash))
+            {
+                const char *tokenEnd = dash;
+
+                while((tokenEnd != end) && !::IsSpace(*tokenEnd))
+                {
+                    tokenEnd++;
+                }
+
+                // errors are reported by the worker converting the block.
+                std::string_view token(dash, tokenEnd - dash);
+
+                if((token.size() >= 2)
+                   && !(settings.reverse && (::IsDecimal(settings, token) != ::Input::BadInput)))
+                {
+                    ::InterpretMode(settings, token);
+                }
+                ::lastError = ::Error::None;
+            }
+        }
+
+        for(char quit : { 'Q', 'q' })
+        {
+            for(const char *c = begin;
+                (c = static_cast<const char*>(std::memchr(c, quit, end - c)));
+                c++)
+            {
+                if(isTokenStart(c))
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    /*
+     * Same as Convert, but the input is split into blocks that are converted
+     * by ::currentSettings.threads worker threads. The output of each block
+     * is written out in input order.
+     */
+    template<typename Reader>
+    static ::BlockResult ConvertParallel(Reader &reader, ::OutputBuffer &out,
+                                         ::ErrorLog &errors)
+    {
+        const unsigned                     numThreads  = ::currentSettings.threads;
+        const std::size_t                  maxInFlight = numThreads * 2;
+        std::deque<std::unique_ptr<Chunk>> inFlight;
+        ::WorkerPool                       pool(numThreads);
+        ::BlockResult                      total;
+        ::Position                         position;
+
+        // waits for the oldest chunk and writes it out, unless the user quit
+        // in an earlier one.
+        auto finishOldest = [&]()
+                            {
+                                std::unique_ptr<Chunk> chunk = std::move(inFlight.front());
+
+                                inFlight.pop_front();
+                                chunk->done.get_future().wait();
+
+                                if(!total.stop)
+                                {
+                                    out.Send(chunk->out);
+                                    errors.Merge(chunk->errors, chunk->err.View());
+                                    errors.Out().Flush();
+                                    total.numFailedInputs += chunk->result.numFailedInputs;
+                                    total.stop             = chunk->result.stop;
+                                    total.summary.Merge(chunk->result.summary);
+                                }
+                            };
+
+        out.Flush();
+        errors.Out().Flush();
+
+        for(bool lastChunk = false; !total.stop && !lastChunk;)
+        {
+            std::string_view block = ::NextBlock(reader, ::currentSettings);
+
+            if(block.empty())
+            {
+                break;
+            }
+
+            auto chunk = std::make_unique<Chunk>(::currentSettings.maxErrors);
+
+            if constexpr(Reader::stableBlocks)
+            {
+                chunk->input = block;
+            }
+            else
+            {
+                chunk->storage.assign(block);
+                chunk->input = chunk->storage;
+            }
+            chunk->settings = ::currentSettings;
+            chunk->errors.StartBlock(chunk->input, position);
+            position = position.After(block);
+
+            // raw input has no flags.
+            if(::currentSettings.rawSize == 0)
+            {
+                lastChunk = ::ScanControlTokens(::currentSettings, block);
+            }
+
+            pool.Submit([c = chunk.get()]()
+                        {
+                            c->result = ::ConvertBlock(c->settings, c->input,
+                                                       c->out, c->errors);
+                            c->done.set_value();
+                        });
+            inFlight.push_back(std::move(chunk));
+
+            while(inFlight.size() >= maxInFlight)
+            {
+                finishOldest();
+            }
+        }
+
+        while(!inFlight.empty())
+        {
+            finishOldest();
+        }
+
+        return total;
+    }
+
+    /*
+     * Converts reader's input with as many threads as the settings ask for.
+     */
+    template<typename Reader>
+    static ::BlockResult ConvertInput(Reader &reader, ::OutputBuffer &out,
+                                      ::ErrorLog &errors)
+    {
+        return (::currentSettings.threads > 1)
+            ? ::ConvertParallel(reader, out, errors) : ::Convert(reader, out, errors);
+    }
+
+    /*
+     * ConvertInput, reading reader's text as a hex dump with --dump.
+     */
+    template<typename Reader>
+    static ::BlockResult ConvertReader(Reader &reader, ::OutputBuffer &out,
+                                       ::ErrorLog &errors)
+    {
+        if(::currentSettings.dump != ::DumpFormat::None)
+        {
+            ::DumpReader<Reader> dump(reader, ::currentSettings.dump);
+
+            return ::ConvertInput(dump, out, errors);
+        }
+
+        return ::ConvertInput(reader, out, errors);
+    }
+
+    /*
+     * Opens the file at path for reading, or returns stdin if path is "-".
+     * Returns -1, with the reason in err, if it could not be opened.
+     */
+    static int OpenPath(const char *path, ::OutputBuffer &err)
+    {
+        if(std::strcmp(path, "-") == 0)
+        {
+            return STDIN_FILENO;
+        }
+
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+
+        if(fd < 0)
+        {
+            err.Write("Error: could not open ");
+            err.Write(path);
+            err.Write(": ");
+            err.Write(std::strerror(errno));
+            err.Put('\n');
+            err.Flush();
+        }
+
+        return fd;
+    }
+
+    /*
+     * Writes error, with its detail, to err on a line of its own. argument is
+     * the program argument it was found in, if any.
+     */
+    static void PrintError(::OutputBuffer &err, ::Error error,
+                           const std::string_view argument = std::string_view(),
+                           const std::string_view detail = std::string_view())
+    {
+        const ::ErrorText &text = ::errorTexts[static_cast<unsigned>(error)];
+
+        err.Write("Error: ");
+        if(!argument.empty())
+        {
+            err.Write(argument);
+            err.Write(" is not recognized.");
+            if(*text.before != '\0')
+            {
+                err.Put(' ');
+            }
+        }
+        err.Write(text.before);
+        err.Write(detail);
+        err.Write(text.after);
+        err.Put('\n');
+        err.Flush();
+    }
+
+    /*
+     * Converts the file at path, or stdin if path is "-". Regular files are
+     * memory mapped (unless --io=uring), anything else is read in blocks,
+     * through io_uring unless --io=sync or it can not be used. Sets bad if
+     * the file could not be opened or read.
+     */
+    static ::BlockResult ConvertPath(const char *path, ::OutputBuffer &out,
+                                     ::ErrorLog &errors, bool &bad)
+    {
+        ::BlockResult result;
+        int           fd = ::OpenPath(path, errors.Out());
+        struct stat   info;
+
+        if(fd < 0)
+        {
+            bad = true;
+            return result;
+        }
+
+        const ::IoBackend io       = ::currentSettings.io;
+        const off_t       position = ::lseek(fd, 0, SEEK_CUR);
+        ::MappedFile      mapped;
+        ::UringReader     queued(fd);
+
+        if((io != ::IoBackend::Uring) && (::fstat(fd, &info) == 0) && S_ISREG(info.st_mode)
+           && mapped.Map(fd, info.st_size, std::max<off_t>(position, 0)))
+        {
+            result = ::ConvertReader(mapped, out, errors);
+            // leave the position after what was converted, as read() would.
+            ::lseek(fd, std::max<off_t>(mapped.Position(), position), SEEK_SET);
+        }
+        else if((io != ::IoBackend::Sync) && queued.Setup())
+        {
+            result = ::ConvertReader(queued, out, errors);
+            bad = bad || queued.Bad();
+        }
+        else
+        {
+            ::BlockReader reader(fd);
+
+            result = ::ConvertReader(reader, out, errors);
+            bad = bad || reader.Bad();
+        }
+
+        if(fd != STDIN_FILENO)
+        {
+            ::close(fd);
+        }
+
+        return result;
+    }
+
+    /*
+     * The type and ends of --sweep. Fails (with a message in err) if an end
+     * does not fit the type, or lo is above hi.
+     */
+    static bool GetSweepRange(const ::Settings &settings, ieee754::Type &type,
+                              ::Bits &first, ::Bits &last, ::OutputBuffer &err)
+    {
+        ieee754::Type firstType = ieee754::ScanHex(settings.sweepFirst, &first,
+                                                   settings.type);
+        ieee754::Type lastType  = ieee754::ScanHex(settings.sweepLast, &last,
+                                                   settings.type);
+
+        // the wider end gives the type.
+        type = std::max(firstType, lastType);
+        if((firstType == ieee754::Type::Bad) || (lastType == ieee754::Type::Bad))
+        {
+            ::PrintError(err, ::Error::SweepType);
+            return false;
+        }
+        else if(first > last)
+        {
+            ::PrintError(err, ::Error::SweepReversed);
+            return false;
+        }
+
+        return true;
+    }
+
+    // values of a sweep converted at a time, and by each job of -j.
+    constexpr std::uint64_t sweepPartSize = 1 << 14;
+
+    /*
+     * Outputs count values of T, the first with the bits first and each
+     * next stride after.
+     */
+    template<typename T>
+    static void SweepValues(const ::Settings &settings, ::Bits first,
+                            std::uint64_t count, ::OutputBuffer &out,
+                            ::BlockResult &result)
+    {
+        const ::Bits stride = settings.sweepStride;
+
+        if(settings.stats)
+        {
+            ::threadStats.values[static_cast<unsigned>(FormatTraits<T>::type)
+                                 - static_cast<unsigned>(ieee754::Type::Half)] += count;
+        }
+
+        for(std::uint64_t i = 0; i < count; i++, first += stride)
+        {
+            ::OutputValue<T>(out, settings, first, result);
+        }
+    }
+
+    /*
+     * Outputs part of a sweep, see SweepValues.
+     */
+    static ::BlockResult SweepPart(const ::Settings &settings, ieee754::Type type,
+                                   ::Bits first, std::uint64_t count,
+                                   ::OutputBuffer &out)
+    {
+        ::BlockResult result;
+        ::StageTimer  timer(settings.stats ? 1 : 0);
+
+        switch(type)
+        {
+        case ieee754::Type::Half:
+            ::SweepValues<::Half>(settings, first, count, out, result);
+            break;
+
+        case ieee754::Type::BFloat16:
+            ::SweepValues<::BFloat16>(settings, first, count, out, result);
+            break;
+
+        case ieee754::Type::Float:
+            ::SweepValues<float>(settings, first, count, out, result);
+            break;
+
+        case ieee754::Type::Double:
+            ::SweepValues<double>(settings, first, count, out, result);
+            break;
+
+        case ieee754::Type::Extended:
+            ::SweepValues<::Extended>(settings, first, count, out, result);
+            break;
+
+        case ieee754::Type::Quad:
+            ::SweepValues<::Quad>(settings, first, count, out, result);
+            break;
+
+        default:
+            break;
+        }
+        timer.Lap(::Stage::Render);
+
+        return result;
+    }
+
+    /*
+     * --sweep: outputs every settings.sweepStride'th value of type from
+     * first to last, in parts of sweepPartSize values. With more than one
+     * thread each part is a Chunk of its own, converted by the workers and
+     * written out in order, like ConvertParallel's.
+     */
+    static ::BlockResult Sweep(const ::Settings &settings, ieee754::Type type,
+                               ::Bits first, ::Bits last, ::OutputBuffer &out)
+    {
+        const ::Bits  stride = settings.sweepStride;
+        // values after the next one, so a sweep of every binary128 fits.
+        ::Bits        left   = (last - first) / stride;
+        bool          done   = false;
+        ::BlockResult total;
+
+        auto nextPart = [&]()
+                        {
+                            if(left < sweepPartSize)
+                            {
+                                done = true;
+                                return static_cast<std::uint64_t>(left) + 1;
+                            }
+
+                            left -= sweepPartSize;
+                            return sweepPartSize;
+                        };
+
+        if(settings.threads <= 1)
+        {
+            while(!done)
+            {
+                const std::uint64_t count = nextPart();
+
+                total.summary.Merge(::SweepPart(settings, type, first, count, out).summary);
+                first += stride * count;
+            }
+
+            return total;
+        }
+
+        const std::size_t                  maxInFlight = settings.threads * 2;
+        std::deque<std::unique_ptr<Chunk>> inFlight;
+        ::WorkerPool                       pool(settings.threads);
+
+        auto finishOldest = [&]()
+                            {
+                                std::unique_ptr<Chunk> chunk = std::move(inFlight.front());
+
+                                inFlight.pop_front();
+                                chunk->done.get_future().wait();
+                                out.Send(chunk->out);
+                                total.summary.Merge(chunk->result.summary);
+                            };
+
+        out.Flush();
+        while(!done)
+        {
+            const std::uint64_t count = nextPart();
+            auto                chunk = std::make_unique<Chunk>(settings.maxErrors);
+
+            pool.Submit([c = chunk.get(), &settings, type, first, count]()
+                        {
+                            c->result = ::SweepPart(settings, type, first, count, c->out);
+                            c->done.set_value();
+                        });
+            inFlight.push_back(std::move(chunk));
+            first += stride * count;
+
+            while(inFlight.size() >= maxInFlight)
+            {
+                finishOldest();
+            }
+        }
+
+        while(!inFlight.empty())
+        {
+            finishOldest();
+        }
+
+        return total;
+    }
+
+    /*
+     * One of the inputs of --diff, its hex values parsed a batch at a time.
+     * Tokens that are not values are kept as Type::Bad.
+     */
+    class DiffInput
+    {
+    public:
+        static constexpr std::size_t batchSize = 1 << 12;
+
+    private:
+        ::BlockReader                 _reader;
+        ::Tokenizer                   _tokens;
+        std::vector<std::string_view> _batch; // of the current block
+
+    public:
+        std::vector<ieee754::Type> types;
+        std::vector<::Bits>        bits;
+        std::size_t                count = 0; // values in the batch
+
+        explicit DiffInput(int fd)
+            : _reader(fd), _tokens(std::string_view()), _batch(batchSize),
+              types(batchSize), bits(batchSize)
+        {
+        }
+
+        /* Parses the next batchSize values, fewer only at the end of the
+           input, as type (Bad to go by the digits). Returns how many. */
+        std::size_t Next(ieee754::Type type)
+        {
+            count = 0;
+            while(count < batchSize)
+            {
+                std::size_t numTokens = 0;
+
+                while((count + numTokens < batchSize) && _tokens.Next(_batch[numTokens]))
+                {
+                    numTokens++;
+                }
+
+                // before the next block overwrites the tokens.
+                ieee754::ScanHex(_batch.data(), numTokens, &types[count], &bits[count], type);
+                count += numTokens;
+
+                if(count < batchSize)
+                {
+                    std::string_view block = _reader.Next();
+
+                    if(block.empty())
+                    {
+                        break;
+                    }
+                    _tokens = ::Tokenizer(block);
+                }
+            }
+
+            return count;
+        }
+
+        bool Bad() const
+        {
+            return _reader.Bad();
+        }
+    };
+
+    /*
+     * The totals of --diff.
+     */
+    struct DiffSummary
+    {
+        std::uint64_t compared     = 0; // pairs of values
+        std::uint64_t differing    = 0;
+        std::uint64_t classChanges = 0;
+        std::uint64_t unordered    = 0; // differing pairs without a distance
+        std::uint64_t notValues    = 0; // pairs of tokens that are not values
+        std::uint64_t onlyFirst    = 0; // values after the other input ended
+        std::uint64_t onlySecond   = 0;
+        ::Bits        maxUlp       = 0;
+        long double   sumUlp       = 0;
+
+        /* Writes the totals to out, which has Write, Put and Fill like
+           OutputBuffer. */
+        template<typename Out>
+        void Print(Out &out) const
+        {
+            char  number[48];
+            char *end;
+
+            auto row = [&](const std::string_view label, ::Bits value)
+                       {
+                           end = ::FormatUnsigned(number, value);
+                           out.Write(label);
+                           out.Fill(' ', 16 - label.size());
+                           out.Write(number, end - number);
+                           out.Put('\n');
+                       };
+
+            out.Write("Differences:\n");
+            row("compared", compared);
+            row("differing", differing);
+            row("class changes", classChanges);
+            row("unordered", unordered);
+            if(notValues != 0)
+            {
+                row("not values", notValues);
+            }
+            if((onlyFirst + onlySecond) != 0)
+            {
+                row("only in first", onlyFirst);
+                row("only in second", onlySecond);
+            }
+            row("max ulp", maxUlp);
+
+            // pairs that are the same count as 0 apart.
+            const std::uint64_t ordered = compared - unordered - notValues;
+
+            end = std::to_chars(number, number + sizeof(number),
+                                static_cast<double>((ordered != 0) ? (sumUlp / ordered) : 0),
+                                std::chars_format::general, 6).ptr;
+            out.Write("mean ulp");
+            out.Fill(' ', 8);
+            out.Write(number, end - number);
+            out.Put('\n');
+        }
+    };
+
+    /*
+     * Writes a signed difference, with its sign.
+     */
+    static void PrintDelta(::OutputBuffer &out, ::Bits from, ::Bits to)
+    {
+        char number[40];
+
+        out.Put((to < from) ? '-' : '+');
+        out.Write(number, ::FormatUnsigned(number, (to < from) ? (from - to) : (to - from))
+                  - number);
+    }
+
+    /*
+     * Prints the index'th pair of --diff, a and b of the same type, which
+     * differ, and counts it in summary.
+     */
+    template<typename T>
+    static void PrintDifference(::OutputBuffer &out, std::uint64_t index, ::Bits a,
+                                ::Bits b, ::DiffSummary &summary)
+    {
+        constexpr unsigned hexDigits = ::IEEE754Float<T>::numBits / 4;
+
+        ::IEEE754Float<T> x;
+        ::IEEE754Float<T> y;
+
+        x = a;
+        y = b;
+
+        const ::FloatClass xClass = x.GetFloatClass();
+        const ::FloatClass yClass = y.GetFloatClass();
+        char               number[40];
+
+        out.Write(number, ::FormatUnsigned(number, index) - number);
+        out.Write(": ");
+        ::FormatHex(out.Extend(hexDigits), a, hexDigits);
+        out.Put(' ');
+        ::FormatHex(out.Extend(hexDigits), b, hexDigits);
+        out.Put(' ');
+        out.Write(::IEEE754Float<T>::Traits::name);
+        out.Write(": ");
+        ::AppendDecimal(out, x, true, 0);
+        out.Write(" vs ");
+        ::AppendDecimal(out, y, true, 0);
+
+        if((xClass == ::FloatClass::NaN) || (yClass == ::FloatClass::NaN))
+        {
+            summary.unordered++;
+        }
+        else
+        {
+            const ::Bits ulp = ieee754::UlpDistance(x, y);
+
+            summary.maxUlp  = std::max(summary.maxUlp, ulp);
+            summary.sumUlp += static_cast<long double>(ulp);
+            out.Write(", ");
+            out.Write(number, ::FormatUnsigned(number, ulp) - number);
+            out.Write(" ulp");
+        }
+
+        if(x.GetSignBit() != y.GetSignBit())
+        {
+            out.Write(", sign flipped");
+        }
+        out.Write(", exponent ");
+        ::PrintDelta(out, x.GetExponentBits(), y.GetExponentBits());
+        out.Write(", mantissa ");
+        ::PrintDelta(out, x.GetMantissaBits(), y.GetMantissaBits());
+
+        if(xClass != yClass)
+        {
+            summary.classChanges++;
+            out.Write(", ");
+            out.Write(x.GetFloatClassification());
+            out.Write(" -> ");
+            out.Write(y.GetFloatClassification());
+        }
+        out.Put('\n');
+    }
+
+    /*
+     * Prints the index'th pair of --diff, which differ in some way, see
+     * PrintDifference.
+     */
+    static void PrintDifference(::OutputBuffer &out, std::uint64_t index,
+                                ieee754::Type firstType, ::Bits a,
+                                ieee754::Type secondType, ::Bits b,
+                                ::DiffSummary &summary)
+    {
+        char number[40];
+
+        summary.differing++;
+        if(firstType != secondType)
+        {
+            summary.unordered++;
+            out.Write(number, ::FormatUnsigned(number, index) - number);
+            out.Write((firstType == ieee754::Type::Bad) ? ": the first is not a value\n"
+                      : (secondType == ieee754::Type::Bad) ? ": the second is not a value\n"
+                      : ": the types differ\n");
+            return;
+        }
+
+        switch(firstType)
+        {
+        case ieee754::Type::Half:
+            ::PrintDifference<::Half>(out, index, a, b, summary);
+            break;
+
+        case ieee754::Type::BFloat16:
+            ::PrintDifference<::BFloat16>(out, index, a, b, summary);
+            break;
+
+        case ieee754::Type::Float:
+            ::PrintDifference<float>(out, index, a, b, summary);
+            break;
+
+        case ieee754::Type::Double:
+            ::PrintDifference<double>(out, index, a, b, summary);
+            break;
+
+        case ieee754::Type::Extended:
+            ::PrintDifference<::Extended>(out, index, a, b, summary);
+            break;
+
+        case ieee754::Type::Quad:
+            ::PrintDifference<::Quad>(out, index, a, b, summary);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    /*
+     * --diff: compares the values of two inputs in lockstep, a batch at a
+     * time. Pairs are compared by their types and bits, and only the ones
+     * that differ are formatted. Prints the totals at the end, and returns
+     * them. Sets bad if an input could not be read.
+     */
+    static ::DiffSummary Diff(const ::Settings &settings, int firstFd, int secondFd,
+                              ::OutputBuffer &out, bool &bad)
+    {
+        auto          first  = std::make_unique<::DiffInput>(firstFd);
+        auto          second = std::make_unique<::DiffInput>(secondFd);
+        ::DiffSummary summary;
+
+        for(;;)
+        {
+            const std::size_t firstCount  = first->Next(settings.type);
+            const std::size_t secondCount = second->Next(settings.type);
+            const std::size_t count       = std::min(firstCount, secondCount);
+
+            for(std::size_t i = 0; i < count; i++)
+            {
+                if(first->types[i] != second->types[i])
+                {
+                    ::PrintDifference(out, summary.compared + i + 1,
+                                      first->types[i], first->bits[i],
+                                      second->types[i], second->bits[i], summary);
+                    out.EndValue();
+                }
+                else if(first->types[i] == ieee754::Type::Bad)
+                {
+                    summary.notValues++;
+                }
+                else if(first->bits[i] != second->bits[i])
+                {
+                    ::PrintDifference(out, summary.compared + i + 1,
+                                      first->types[i], first->bits[i],
+                                      second->types[i], second->bits[i], summary);
+                    out.EndValue();
+                }
+            }
+            summary.compared += count;
+
+            if(firstCount != secondCount)
+            {
+                // one ended; the rest of the other is counted, not compared.
+                ::DiffInput &longer = (firstCount > secondCount) ? *first : *second;
+                std::uint64_t &only = (firstCount > secondCount) ? summary.onlyFirst
+                    : summary.onlySecond;
+
+                for(only = longer.count - count; longer.Next(settings.type) != 0;)
+                {
+                    only += longer.count;
+                }
+                break;
+            }
+            else if(count == 0)
+            {
+                break;
+            }
+        }
+
+        bad = first->Bad() || second->Bad();
+        summary.Print(out);
+        return summary;
+    }
+
+    /*
+     * The input and output of one client of the server. Input arrives in
+     * pieces of any size; the whole tokens (or raw values) received so far
+     * are converted with the session's own settings, and the output collects
+     * until the server sends it.
+     */
+    class Session
+    {
+    private:
+        ::Settings     _settings;
+        std::string    _input;        // received, but not converted yet
+        ::OutputBuffer _out;          // output and errors, in order
+        ::ErrorLog     _errors;
+        ::Position     _position;     // of the input
+        ::Summary      _summary;
+        bool           _done = false; // quit, or no more input
+
+        /* Converts the first size bytes of the input. */
+        void convert(std::size_t size)
+        {
+            const std::string_view block(_input.data(), size);
+
+            _errors.StartBlock(block, _position);
+            _position = _position.After(block);
+
+            ::BlockResult result = ::ConvertBlock(_settings, block, _out, _errors);
+
+            _input.erase(0, size);
+            _summary.Merge(result.summary);
+            if(result.stop)
+            {
+                finish();
+            }
+        }
+
+        void finish()
+        {
+            _done = true;
+            _input.clear();
+            _errors.PrintHidden();
+            if(_settings.summary)
+            {
+                _summary.Print(_out);
+            }
+        }
+
+    public:
+        explicit Session(const ::Settings &settings)
+            : _settings(settings), _errors(_out, settings.maxErrors)
+        {
+            if((_settings.format == ::Format::Csv) && !_settings.summary)
+            {
+                _out.Write(::csvHeader);
+            }
+        }
+
+        /* Converts what data completes, keeping a token (or raw value) it
+           cuts off for the next call. */
+        void Receive(const std::string_view data)
+        {
+            if(_done)
+            {
+                return;
+            }
+
+            _input.append(data);
+
+            std::size_t size = _input.size();
+
+            if(_settings.rawSize != 0)
+            {
+                size -= size % _settings.rawSize;
+            }
+            else
+            {
+                while((size != 0) && !::IsSpace(_input[size - 1]))
+                {
+                    size--;
+                }
+            }
+
+            if(size != 0)
+            {
+                convert(size);
+            }
+        }
+
+        /* The client has no more input, converts what is left. */
+        void End()
+        {
+            if(_done)
+            {
+                return;
+            }
+            else if(!_input.empty())
+            {
+                convert(_input.size());
+            }
+
+            if(!_done)
+            {
+                finish();
+            }
+        }
+
+        /* True once the client quit or ended its input. */
+        bool Done() const
+        {
+            return _done;
+        }
+
+        ::OutputBuffer &Out()
+        {
+            return _out;
+        }
+    };
+
+    /*
+     * --listen: converts for any number of clients on a Unix socket, so they
+     * do not start a process per batch of values. A single thread waits on
+     * all of them with epoll and converts whatever input has arrived; each
+     * client has its own Session, so its flags do not affect the others.
+     */
+    class Server
+    {
+    private:
+        static constexpr std::size_t readSize   = 1 << 16;
+        // a client's input is not read while it has this much output unsent.
+        static constexpr std::size_t maxPending = 1 << 22;
+        static constexpr int         maxEvents  = 64;
+
+        struct Connection
+        {
+            int           fd;
+            ::Session     session;
+            std::size_t   sent   = 0; // of the session's output
+            std::uint32_t events = EPOLLIN;
+
+            Connection(int fd, const ::Settings &settings)
+                : fd(fd), session(settings)
+            {
+            }
+        };
+
+        const ::Settings &_settings;
+        std::string       _path;
+        int               _listenFd = -1;
+        int               _signalFd = -1;
+        int               _epollFd  = -1;
+        std::vector<char> _readBuf;
+        std::unordered_map<int, std::unique_ptr<Connection>> _connections;
+
+        /* Writes what failed and errno's message to err. */
+        static void error(::OutputBuffer &err, const char *what)
+        {
+            err.Write("Error: ");
+            err.Write(what);
+            err.Write(": ");
+            err.Write(std::strerror(errno));
+            err.Put('\n');
+            err.Flush();
+        }
+
+        bool watch(int fd, std::uint32_t events, int op = EPOLL_CTL_ADD)
+        {
+            epoll_event event = {};
+
+            event.events  = events;
+            event.data.fd = fd;
+            return ::epoll_ctl(_epollFd, op, fd, &event) == 0;
+        }
+
+        void accept()
+        {
+            for(;;)
+            {
+                int fd = ::accept4(_listenFd, nullptr, nullptr,
+                                   SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+                if(fd < 0)
+                {
+                    // EAGAIN once all waiting clients are in, anything else
+                    // (out of descriptors) is left for the next wake up.
+                    return;
+                }
+
+                auto connection = std::make_unique<Connection>(fd, _settings);
+
+                if(!watch(fd, connection->events))
+                {
+                    ::close(fd);
+                    continue;
+                }
+
+                _connections.emplace(fd, std::move(connection));
+            }
+        }
+
+        void close(Connection &connection)
+        {
+            int fd = connection.fd;
+
+            // closing removes it from the epoll set.
+            ::close(fd);
+            _connections.erase(fd);
+        }
+
+        std::size_t pending(Connection &connection)
+        {
+            return connection.session.Out().View().size() - connection.sent;
+        }
+
+        /* Sends as much of the output as the socket takes. Returns false if
+           the client is gone. */
+        bool send(Connection &connection)
+        {
+            ::OutputBuffer        &out  = connection.session.Out();
+            const std::string_view data = out.View();
+
+            while(connection.sent < data.size())
+            {
+                ssize_t result = ::send(connection.fd, data.data() + connection.sent,
+                                        data.size() - connection.sent, MSG_NOSIGNAL);
+                if(result < 0)
+                {
+                    if(errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+                }
+
+                connection.sent         += result;
+                ::threadStats.bytesOut += result;
+            }
+
+            out.Clear();
+            connection.sent = 0;
+            return true;
+        }
+
+        /* Reads one batch of input, converts it and sends back what the
+           socket takes. */
+        void serve(Connection &connection, std::uint32_t events)
+        {
+            if((events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !connection.session.Done()
+               && (pending(connection) < maxPending))
+            {
+                ssize_t bytesRead = ::read(connection.fd, _readBuf.data(), _readBuf.size());
+
+                if(bytesRead > 0)
+                {
+                    connection.session.Receive(std::string_view(_readBuf.data(), bytesRead));
+                }
+                else if(bytesRead == 0)
+                {
+                    connection.session.End();
+                }
+                else if((errno != EINTR) && (errno != EAGAIN) && (errno != EWOULDBLOCK))
+                {
+                    close(connection);
+                    return;
+                }
+            }
+
+            if(!send(connection))
+            {
+                close(connection);
+                return;
+            }
+
+            std::size_t   unsent = pending(connection);
+            std::uint32_t wanted = (unsent != 0) ? std::uint32_t(EPOLLOUT) : 0u;
+
+            if(connection.session.Done() && (unsent == 0))
+            {
+                close(connection);
+                return;
+            }
+            else if(!connection.session.Done() && (unsent < maxPending))
+            {
+                wanted |= EPOLLIN;
+            }
+
+            if((wanted != connection.events) && watch(connection.fd, wanted, EPOLL_CTL_MOD))
+            {
+                connection.events = wanted;
+            }
+        }
+
+    public:
+        explicit Server(const ::Settings &settings)
+            : _settings(settings), _readBuf(readSize)
+        {
+        }
+
+        Server(const Server&) = delete;
+        Server &operator=(const Server&) = delete;
+
+        ~Server()
+        {
+            for(auto &entry : _connections)
+            {
+                ::close(entry.first);
+            }
+
+            for(int fd : { _listenFd, _signalFd, _epollFd })
+            {
+                if(fd >= 0)
+                {
+                    ::close(fd);
+                }
+            }
+
+            if(_listenFd >= 0)
+            {
+                ::unlink(_path.c_str());
+            }
+        }
+
+        /* Creates the socket at path, replacing a socket left there by an
+           earlier run. Returns false, with the reason in err, if it could
+           not. */
+        bool Listen(const std::string_view path, ::OutputBuffer &err)
+        {
+            sockaddr_un address = {};
+            struct stat info;
+            sigset_t    signals;
+
+            if(path.size() >= sizeof(address.sun_path))
+            {
+                err.Write("Error: the socket path is too long.\n");
+                err.Flush();
+                return false;
+            }
+
+            _path.assign(path);
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, _path.c_str(), _path.size() + 1);
+
+            if((::stat(_path.c_str(), &info) == 0) && S_ISSOCK(info.st_mode))
+            {
+                ::unlink(_path.c_str());
+            }
+
+            // SIGINT and SIGTERM end Run, so the socket is removed.
+            sigemptyset(&signals);
+            sigaddset(&signals, SIGINT);
+            sigaddset(&signals, SIGTERM);
+
+            _epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+            if(_epollFd < 0)
+            {
+                error(err, "could not create an epoll instance");
+                return false;
+            }
+
+            int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+            if((fd < 0)
+               || (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0))
+            {
+                error(err, "could not create the socket");
+                if(fd >= 0)
+                {
+                    ::close(fd);
+                }
+                return false;
+            }
+
+            _listenFd = fd;
+            if((::listen(_listenFd, SOMAXCONN) != 0) || !watch(_listenFd, EPOLLIN))
+            {
+                error(err, "could not listen on the socket");
+                return false;
+            }
+
+            if((::sigprocmask(SIG_BLOCK, &signals, nullptr) != 0)
+               || ((_signalFd = ::signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC)) < 0)
+               || !watch(_signalFd, EPOLLIN))
+            {
+                error(err, "could not wait for signals");
+                return false;
+            }
+
+            return true;
+        }
+
+        /* Serves clients until SIGINT or SIGTERM. Returns false, with the
+           reason in err, if waiting failed. */
+        bool Run(::OutputBuffer &err)
+        {
+            epoll_event events[maxEvents];
+
+            for(;;)
+            {
+                int numEvents = ::epoll_wait(_epollFd, events, maxEvents, -1);
+
+                if(numEvents < 0)
+                {
+                    if(errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    error(err, "could not wait for clients");
+                    return false;
+                }
+
+                for(int i = 0; i < numEvents; i++)
+                {
+                    int fd = events[i].data.fd;
+
+                    if(fd == _signalFd)
+                    {
+                        return true;
+                    }
+                    else if(fd == _listenFd)
+                    {
+                        accept();
+                    }
+                    // a connection closed earlier in this batch is skipped.
+                    else if(auto found = _connections.find(fd); found != _connections.end())
+                    {
+                        serve(*found->second, events[i].events);
+                    }
+                }
+            }
+        }
+    };
+}
+
+#ifndef FLOAT_NO_MAIN
+/*
+ * Runs main.
+ */
+int main(const int argc, const char *argv[])
+{
+    bool        cont = true;
+    int         numFailedInputs = 0; /*  main return value (unless another error
+                                         occurs). number of user inputs that
+                                         could not be converted into floats.  */                             
+    ::OutputBuffer out(STDOUT_FILENO);
+    ::OutputBuffer err(STDERR_FILENO);
+    const auto     start = std::chrono::steady_clock::now();
+
+    // --stats' report, once every thread has merged its stats.
+    auto reportStats = [&]()
+                       {
+                           std::chrono::duration<double> elapsed
+                               = std::chrono::steady_clock::now() - start;
+
+                           ::MergeThreadStats();
+                           ::totalStats.Print(err, elapsed.count());
+                           err.Flush();
+                       };
+
+    // finishes writing the output, and reports it if any of it was lost.
+    auto outputFailed = [&]()
+                        {
+                            if(out.Finish())
+                            {
+                                return false;
+                            }
+
+                            err.Write("Error: could not write the output: ");
+                            err.Write(std::strerror(out.Error()));
+                            err.Put('\n');
+                            err.Flush();
+                            return true;
+                        };
+
+    std::vector<const char*> paths; // files to convert, in order
+    bool                     bad = false;
+
+    // interpret command line arguments, anything that is not a flag is a file.
+    for(int i = 1; i < argc; i++)
+    {
+        if((argv[i][0] != '-') || (argv[i][1] == '\0'))
+        {
+            paths.push_back(argv[i]);
+        }
+        else if(!::InterpretMode(::currentSettings, argv[i], true))
+        {
+            ::PrintError(err, ::lastError, argv[i], ::lastErrorDetail);
+            ::lastError = ::Error::None;
+            numFailedInputs = -2;
+            cont = false;
+        }
+        // exit immediately if help was called
+        else if(::currentSettings.printHelp)
+        {
+            cont = false;
+            out.Write(::helpStr);
+            out.Put('\n');
+            break;
+        }
+    }
+
+    if(cont && !::currentSettings.listenPath.empty())
+    {
+        if(!paths.empty())
+        {
+            ::PrintError(err, ::Error::FilesWithListen);
+            return -2;
+        }
+        else if(::currentSettings.dump != ::DumpFormat::None)
+        {
+            ::PrintError(err, ::Error::DumpWithListen);
+            return -2;
+        }
+
+        ::Server server(::currentSettings);
+        int      result = (server.Listen(::currentSettings.listenPath, err)
+                           && server.Run(err)) ? 0 : -1;
+
+        if(::currentSettings.stats)
+        {
+            reportStats();
+        }
+
+        return result;
+    }
+
+    const bool    sweep      = cont && !::currentSettings.sweepFirst.empty();
+    ieee754::Type sweepType  = ieee754::Type::Bad;
+    ::Bits        sweepFirst = 0;
+    ::Bits        sweepLast  = 0;
+
+    if(cont && ::currentSettings.diff)
+    {
+        if(paths.size() != 2)
+        {
+            ::PrintError(err, ::Error::DiffNeedsTwoFiles);
+            return -2;
+        }
+        else if(::currentSettings.dump != ::DumpFormat::None)
+        {
+            ::PrintError(err, ::Error::DumpWithDiff);
+            return -2;
+        }
+
+        int           firstFd  = ::OpenPath(paths[0], err);
+        int           secondFd = (firstFd < 0) ? -1 : ::OpenPath(paths[1], err);
+        ::DiffSummary summary;
+
+        if(secondFd >= 0)
+        {
+            summary = ::Diff(::currentSettings, firstFd, secondFd, out, bad);
+        }
+
+        for(int fd : { firstFd, secondFd })
+        {
+            if(fd > STDIN_FILENO)
+            {
+                ::close(fd);
+            }
+        }
+
+        const bool unwritten = outputFailed();
+
+        if((secondFd < 0) || bad)
+        {
+            ::PrintError(err, ::Error::BadInput);
+            return -1;
+        }
+        else if(unwritten)
+        {
+            return -1;
+        }
+
+        return static_cast<int>(std::min<std::uint64_t>(summary.differing,
+                                                        std::numeric_limits<int>::max()));
+    }
+
+    if(sweep && !paths.empty())
     {
-        std::cerr << "Error in input.\nNumber of failed inputs: "
-                  << numFailedInputs << '\n';
-        std::cin.clear();
+        ::PrintError(err, ::Error::FilesWithSweep);
+        return -2;
+    }
+    else if(sweep && !::GetSweepRange(::currentSettings, sweepType, sweepFirst, sweepLast,
+                                      err))
+    {
+        return -2;
+    }
+    else if(paths.empty())
+    {
+        paths.push_back("-");
+    }
+
+    if(cont && (::currentSettings.format == ::Format::Csv) && !::currentSettings.summary)
+    {
+        out.Write(::csvHeader);
+    }
+
+    struct stat outInfo;
+    struct stat errInfo;
+
+    // output goes out while the next is converted, unless it would then
+    // come out of order with the errors, written to the same file.
+    if(cont && (::currentSettings.io != ::IoBackend::Sync)
+       && !((::fstat(STDOUT_FILENO, &outInfo) == 0) && (::fstat(STDERR_FILENO, &errInfo) == 0)
+            && (outInfo.st_dev == errInfo.st_dev) && (outInfo.st_ino == errInfo.st_ino)))
+    {
+        out.WriteAsync();
+    }
+
+    ::Summary  summary;
+    ::ErrorLog errors(err, ::currentSettings.maxErrors);
+    bool       converted = cont;
+
+    if(sweep)
+    {
+        summary.Merge(::Sweep(::currentSettings, sweepType, sweepFirst, sweepLast,
+                              out).summary);
+        cont = false;
+    }
+
+    // main loop, flags in one file carry over to the next.
+    for(std::size_t i = 0; cont && (i < paths.size()); i++)
+    {
+        ::BlockResult result = ::ConvertPath(paths[i], out, errors, bad);
+
+        numFailedInputs += result.numFailedInputs;
+        cont             = !result.stop;
+        summary.Merge(result.summary);
+    }
+
+    if(converted && ::currentSettings.summary)
+    {
+        summary.Print(out);
+    }
+
+    out.Flush();
+    errors.PrintHidden();
+
+    // checking if there was an error in input or output.
+    const bool unwritten = outputFailed();
+
+    err.Flush();
+
+    if(converted && ::currentSettings.stats)
+    {
+        reportStats();
+    }
+
+    if(bad)
+    {
+        char digits[12];
+
+        ::PrintError(err, ::Error::BadInput);
+        err.Write("Number of failed inputs: ");
+        err.Write(digits, std::to_chars(digits, digits + sizeof(digits), numFailedInputs).ptr
+                          - digits);
+        err.Put('\n');
+        err.Flush();
         return -1;
     }
     
-    return numFailedInputs;
+    return unwritten ? -1 : numFailedInputs;
 }
+#endif // FLOAT_NO_MAIN
@@ -1,8 +1,9 @@
 #include <iostream>
 #include <string>
-#include <sstream>
 #include <iomanip>
-#include <algorithm>
+#include <string_view>
+
+#include "ieee754.hpp"
 
 enum class Input
 {
@@ -13,149 +14,61 @@ enum class Input
     Double,
 };
 
-// union trick
-union hexCoverter2f
-{
-    unsigned int _uint;
-    float _float;
-};
-
-union hexCoverter2d
-{
-    unsigned long _ulong;
-    double _double;
-};
-
-float h2f(std::string &hex)
+float h2f(ieee754::Bits bits)
 {
-    hexCoverter2f hc2f;
-    std::istringstream hexVal(hex);
-    hexVal >> std::hex >> hc2f._uint;
+    ieee754::Float value;
+    value = bits;
 
-    return hc2f._float;
+    return value.GetIEEEFloat();
 }
 
-double h2d(std::string &hex)
+double h2d(ieee754::Bits bits)
 {
-    hexCoverter2d hc2d;
-    std::istringstream hexVal(hex);
-    hexVal >> std::hex >> hc2d._ulong;
+    ieee754::Double value;
+    value = bits;
 
-    return hc2d._double;
+    return value.GetIEEEFloat();
 }
 
-Input floatOrDouble(std::string &input)
+Input parseInput(std::string_view input, ieee754::Bits &bits)
 {
-    constexpr unsigned int floatSize = 8u;
-    constexpr unsigned int doubleSize = 16u;
-
-    Input result = Input::BadInput;
-
-    auto check = [&](std::string in, bool oversized = true)
-        {
-            constexpr int beginNum = 48;
-            constexpr int endNum   = 57;
+    if((input.size() == 4)
+       && ((input[0] | 0x20) == 'q') && ((input[1] | 0x20) == 'u')
+       && ((input[2] | 0x20) == 'i') && ((input[3] | 0x20) == 't'))
+        return Input::Exit;
 
-            constexpr int beginLet = 65;
-            constexpr int endLet   = 90;
-            
-            if(oversized)
-            {
-                if(!(in[0] == '0')
-                   && ((in[1] == 'X')
-                       || (in[1] == 'x')))
-                {
-                    return false;
-                }
-            }
-
-            for(char c : in)
-            {
-                if((c < beginNum) ||
-                   ((c > endNum) &&
-                    (c < beginLet)) ||
-                   (c > endLet))
-                {
-                    return false;
-                }
-            }
-
-            return true;
-        };
-
-    switch(input.size())
+    switch(ieee754::ScanHex(input, &bits))
     {
-    case floatSize + 2u:
-        if(check(input))
-            result = Input::Float;
-        break;
-    case floatSize:
-        if(check(input, false))
-            result = Input::Float;
-        break;
-
-        
-    case doubleSize + 2u:
-        if(check(input))
-            result = Input::Double;
-        break;
-    case doubleSize:
-        if(check(input))
-            result = Input::Double;
-        break;
-        
+    case ieee754::Type::Float:
+        return Input::Float;
+    case ieee754::Type::Double:
+        return Input::Double;
     default:
-        break;
+        return Input::BadInput;
     }
-
-    return result;
-}
-
-Input parseInput(std::string &input)
-{
-    if(input == "QUIT")
-        return Input::Exit;
-        
-    constexpr unsigned int minSize = 4u;
-
-    if(input.size() <= minSize)
-           return Input::BadInput;
-
-    return floatOrDouble(input);
-}
-
-
-char change_case (char c)
-{
-    if (std::isupper(c)) 
-        return std::tolower(c); 
-    else
-        return std::toupper(c); 
 }
 
 /**
 
  */ 
-int main(int argc, char **argv)
+int main()
 {
     bool shouldQuit = false;
 
     std::string input;
     while(!shouldQuit && (std::cin >> input))
     {
-        Input inputCode;
-        std::transform(input.begin(), input.end(), input.begin(), change_case);
-
-        inputCode = parseInput(input);
+        ieee754::Bits bits;
+        Input inputCode = parseInput(input, bits);
 
         switch (inputCode)
         {
         case Input::Float: 
-            std::cout << h2f(input) << '\n';
+            std::cout << h2f(bits) << '\n';
             break;
 
         case Input::Double:
-            std::cout << h2d(input) << '\n';
+            std::cout << h2d(bits) << '\n';
             break;
 
         case Input::Exit:
@@ -0,0 +1,409 @@
+/*
+ * Hexadecimal string decoding shared by the float tools.
+ *
+ * Scan validates a whole token (optional "0x" prefix, up to 32 digits of
+ * either case) and decodes it in the same pass. The Decode functions take 1 to 16 hex
+ * digits that are already known to be valid. On x86 the digits are handled
+ * with SSE2, SSSE3 or AVX2 depending on what the CPU supports, which is picked
+ * once at runtime. Everything else gets the table driven scalar loop.
+ */
+#ifndef HEX_HPP
+#define HEX_HPP
+
+#include <cstdint>     // uint64_t
+#include <cstddef>     // size_t
+#include <cstring>     // memcpy, memset
+#include <string_view> // string_view
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h> // SSE2, SSSE3, AVX2 intrinsics
+#define HEX_HAS_X86 1
+#endif
+
+namespace hex
+{
+    // largest number of digits the decoders take.
+    constexpr std::size_t maxDigits = 16;
+
+    // largest number of digits Scan takes, enough for 128 bits.
+    constexpr std::size_t maxScanDigits = 32;
+
+    /*
+     * Width class of a token, decided by its number of digits.
+     */
+    enum class Width : unsigned char
+    {
+        Bad,      // empty, too long, or not hex
+        Float,    // 1 to 8 digits
+        Double,   // 9 to 16 digits
+        Extended, // 17 to 20 digits
+        Quad,     // 21 to 32 digits
+    };
+
+    /*
+     * Result of Scan.
+     */
+    struct ScanResult
+    {
+        Width            width = Width::Bad;
+        std::string_view digits;    // token without the "0x" prefix
+        std::uint64_t    value = 0; // only set if width is not Bad
+        std::uint64_t    high  = 0; // value of the digits before the last 16
+    };
+
+    /*
+     * Returns str without a leading "0x" or "0X".
+     */
+    inline std::string_view StripPrefix(std::string_view str)
+    {
+        if((str.size() >= 2) && (str[0] == '0')
+           && ((str[1] == 'x') || (str[1] == 'X')))
+        {
+            str.remove_prefix(2);
+        }
+
+        return str;
+    }
+
+    namespace detail
+    {
+        /* Value of a single hex digit, either case. */
+        inline unsigned DigitValue(char c)
+        {
+            return (c & 0xF) + (9 * ((c >> 6) & 1));
+        }
+
+        /* Digit values, with every bit above the low nibble set for bytes
+           that are not hex digits. */
+        struct DigitTable
+        {
+            unsigned char values[256];
+
+            constexpr DigitTable()
+                : values()
+            {
+                for(unsigned i = 0; i < 256; i++)
+                {
+                    values[i] = 0xF0;
+                }
+
+                for(unsigned i = 0; i < 10; i++)
+                {
+                    values['0' + i] = i;
+                }
+
+                for(unsigned i = 0; i < 6; i++)
+                {
+                    values['A' + i] = values['a' + i] = 10 + i;
+                }
+            }
+        };
+
+        inline constexpr DigitTable digitTable;
+
+        inline Width WidthOf(std::size_t digits)
+        {
+            return (digits <= 8)  ? Width::Float
+                :  (digits <= 16) ? Width::Double
+                :  (digits <= 20) ? Width::Extended
+                :                   Width::Quad;
+        }
+
+        inline ScanResult ScanScalar(std::string_view token)
+        {
+            ScanResult result;
+            unsigned   invalid = 0;
+
+            result.digits = StripPrefix(token);
+            if(result.digits.empty() || (result.digits.size() > maxScanDigits))
+            {
+                return result;
+            }
+
+            for(char c : result.digits)
+            {
+                unsigned digit = digitTable.values[static_cast<unsigned char>(c)];
+
+                invalid |= digit;
+                result.high  = (result.high << 4) | (result.value >> 60);
+                result.value = (result.value << 4) | (digit & 0xF);
+            }
+
+            result.width = (invalid & 0xF0) ? Width::Bad
+                : WidthOf(result.digits.size());
+
+            return result;
+        }
+
+        inline std::uint64_t DecodeScalar(std::string_view str)
+        {
+            std::uint64_t value = 0;
+
+            for(char c : str)
+            {
+                value = (value << 4) | DigitValue(c);
+            }
+
+            return value;
+        }
+
+#ifdef HEX_HAS_X86
+        /* Right aligns the digits of str in 16 bytes padded with '0', so every
+           token looks like a 16 digit one to the vector code. */
+        inline __m128i LoadDigits(std::string_view str)
+        {
+            alignas(16) char padded[maxDigits];
+
+            std::memset(padded, '0', sizeof(padded));
+            std::memcpy(padded + (maxDigits - str.size()), str.data(),
+                        str.size());
+
+            return _mm_load_si128(reinterpret_cast<const __m128i*>(padded));
+        }
+
+        /* Turns 16 ASCII hex digits into 16 nibbles, one per byte. Letters
+           have bit 6 set, digits do not. */
+        inline __m128i DigitsToNibbles(__m128i digits)
+        {
+            const __m128i letterBit = _mm_set1_epi8(0x40);
+            const __m128i isLetter  = _mm_cmpeq_epi8(_mm_and_si128(digits, letterBit),
+                                                     letterBit);
+
+            return _mm_add_epi8(_mm_and_si128(digits, _mm_set1_epi8(0x0F)),
+                                _mm_and_si128(isLetter, _mm_set1_epi8(9)));
+        }
+
+        /* Checks that all 16 bytes are hex digits and turns them into
+           nibbles. Letters are case folded before the range check. */
+        inline bool ValidateDigits(__m128i digits, __m128i &nibbles)
+        {
+            const __m128i folded   = _mm_or_si128(digits, _mm_set1_epi8(0x20));
+            const __m128i isDigit  = _mm_and_si128(_mm_cmpgt_epi8(digits, _mm_set1_epi8('0' - 1)),
+                                                   _mm_cmplt_epi8(digits, _mm_set1_epi8('9' + 1)));
+            const __m128i isLetter = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)),
+                                                   _mm_cmplt_epi8(folded, _mm_set1_epi8('f' + 1)));
+
+            nibbles = _mm_add_epi8(_mm_and_si128(digits, _mm_set1_epi8(0x0F)),
+                                   _mm_and_si128(isLetter, _mm_set1_epi8(9)));
+
+            return _mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) == 0xFFFF;
+        }
+
+        inline std::uint64_t NibblesToValueSSE2(__m128i nibbles)
+        {
+            // join each pair of nibbles into a byte, most significant first.
+            __m128i bytes = _mm_or_si128(_mm_slli_epi16(nibbles, 4),
+                                         _mm_srli_epi16(nibbles, 8));
+            bytes = _mm_and_si128(bytes, _mm_set1_epi16(0x00FF));
+            bytes = _mm_packus_epi16(bytes, bytes);
+
+            std::uint64_t value;
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(&value), bytes);
+
+            return __builtin_bswap64(value);
+        }
+
+        __attribute__((target("ssse3")))
+        inline std::uint64_t NibblesToValueSSSE3(__m128i nibbles)
+        {
+            // high * 16 + low for each pair, then gather the low byte of each
+            // pair in reverse order to get the little endian value.
+            __m128i pairs = _mm_maddubs_epi16(nibbles, _mm_set1_epi16(0x0110));
+            __m128i value = _mm_shuffle_epi8(pairs,
+                                             _mm_setr_epi8(14, 12, 10, 8, 6, 4, 2, 0,
+                                                           -1, -1, -1, -1,
+                                                           -1, -1, -1, -1));
+
+            std::uint64_t result;
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(&result), value);
+
+            return result;
+        }
+
+        inline std::uint64_t DecodeSSE2(std::string_view str)
+        {
+            return NibblesToValueSSE2(DigitsToNibbles(LoadDigits(str)));
+        }
+
+        __attribute__((target("ssse3")))
+        inline std::uint64_t DecodeSSSE3(std::string_view str)
+        {
+            return NibblesToValueSSSE3(DigitsToNibbles(LoadDigits(str)));
+        }
+
+        /* Scans a token with one vector load per 16 digits. The padding is
+           '0', so it never fails validation and decodes to leading zeros. */
+        template<std::uint64_t (*nibblesToValue)(__m128i)>
+        inline ScanResult ScanVector(std::string_view token)
+        {
+            ScanResult       result;
+            std::string_view low;
+            __m128i          nibbles;
+
+            result.digits = StripPrefix(token);
+            if(result.digits.empty() || (result.digits.size() > maxScanDigits))
+            {
+                return result;
+            }
+
+            low = result.digits;
+            if(low.size() > maxDigits)
+            {
+                std::string_view high = low.substr(0, low.size() - maxDigits);
+
+                low.remove_prefix(high.size());
+                if(!ValidateDigits(LoadDigits(high), nibbles))
+                {
+                    return result;
+                }
+                result.high = nibblesToValue(nibbles);
+            }
+
+            if(ValidateDigits(LoadDigits(low), nibbles))
+            {
+                result.value = nibblesToValue(nibbles);
+                result.width = WidthOf(result.digits.size());
+            }
+
+            return result;
+        }
+
+        inline ScanResult ScanSSE2(std::string_view token)
+        {
+            return ScanVector<NibblesToValueSSE2>(token);
+        }
+
+        __attribute__((target("ssse3")))
+        inline ScanResult ScanSSSE3(std::string_view token)
+        {
+            return ScanVector<NibblesToValueSSSE3>(token);
+        }
+
+        /* Decodes two tokens at once, one per 128 bit lane. */
+        __attribute__((target("avx2")))
+        inline void DecodePairAVX2(std::string_view first, std::string_view second,
+                                   std::uint64_t *out)
+        {
+            __m256i digits = _mm256_set_m128i(LoadDigits(second), LoadDigits(first));
+
+            const __m256i letterBit = _mm256_set1_epi8(0x40);
+            const __m256i isLetter  = _mm256_cmpeq_epi8(_mm256_and_si256(digits, letterBit),
+                                                        letterBit);
+            __m256i nibbles = _mm256_add_epi8(_mm256_and_si256(digits, _mm256_set1_epi8(0x0F)),
+                                              _mm256_and_si256(isLetter, _mm256_set1_epi8(9)));
+
+            __m256i pairs = _mm256_maddubs_epi16(nibbles, _mm256_set1_epi16(0x0110));
+            __m256i value = _mm256_shuffle_epi8(pairs,
+                                                _mm256_setr_epi8(14, 12, 10, 8, 6, 4, 2, 0,
+                                                                 -1, -1, -1, -1,
+                                                                 -1, -1, -1, -1,
+                                                                 14, 12, 10, 8, 6, 4, 2, 0,
+                                                                 -1, -1, -1, -1,
+                                                                 -1, -1, -1, -1));
+            // bring both values into the low 128 bits.
+            value = _mm256_permute4x64_epi64(value, 0x08);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                             _mm256_castsi256_si128(value));
+        }
+#endif
+
+        using DecodeFunc = std::uint64_t (*)(std::string_view);
+
+        /* Picks the best single token decoder for this CPU. */
+        inline DecodeFunc SelectDecode()
+        {
+#ifdef HEX_HAS_X86
+            __builtin_cpu_init();
+
+            if(__builtin_cpu_supports("ssse3"))
+            {
+                return DecodeSSSE3;
+            }
+
+            return DecodeSSE2;
+#else
+            return DecodeScalar;
+#endif
+        }
+
+        using ScanFunc = ScanResult (*)(std::string_view);
+
+        /* Picks the best scanner for this CPU. */
+        inline ScanFunc SelectScan()
+        {
+#ifdef HEX_HAS_X86
+            __builtin_cpu_init();
+
+            if(__builtin_cpu_supports("ssse3"))
+            {
+                return ScanSSSE3;
+            }
+
+            return ScanSSE2;
+#else
+            return ScanScalar;
+#endif
+        }
+
+        inline bool HasAVX2()
+        {
+#ifdef HEX_HAS_X86
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+        }
+    }
+
+    /*
+     * Validates token (optional "0x" prefix, 1 to maxScanDigits hex digits of
+     * either case), decodes it and reports its width class in one pass.
+     */
+    inline ScanResult Scan(std::string_view token)
+    {
+        static const detail::ScanFunc scan = detail::SelectScan();
+
+        return scan(token);
+    }
+
+    /*
+     * Decodes 1 to maxDigits validated hex digits (either case, no prefix).
+     */
+    inline std::uint64_t Decode(std::string_view str)
+    {
+        static const detail::DecodeFunc decode = detail::SelectDecode();
+
+        return decode(str);
+    }
+
+    /*
+     * Decodes count tokens into out. Same rules as Decode.
+     */
+    inline void Decode(const std::string_view *strs, std::size_t count,
+                       std::uint64_t *out)
+    {
+        static const bool hasAVX2 = detail::HasAVX2();
+        std::size_t       i = 0;
+
+#ifdef HEX_HAS_X86
+        if(hasAVX2)
+        {
+            for(; (i + 2) <= count; i += 2)
+            {
+                detail::DecodePairAVX2(strs[i], strs[i + 1], out + i);
+            }
+        }
+#else
+        (void) hasAVX2;
+#endif
+
+        for(; i < count; i++)
+        {
+            out[i] = Decode(strs[i]);
+        }
+    }
+}
+
+#endif // HEX_HPP
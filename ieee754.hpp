@@ -0,0 +1,1990 @@
+/*
+ * The bit patterns of IEEE 754 style floats: reading them from hex or
+ * decimal text, classifying them, and printing their values and tables.
+ * Header only; float, h2f and the tests are built on it, and other programs
+ * can convert in process with the batch functions at the end instead of
+ * running float.
+ */
+
+#ifndef IEEE754_HPP
+#define IEEE754_HPP
+
+#include <cstdint>     // uint16_t, uint32_t, uint64_t
+#include <cstddef>     // size_t
+#include <cstring>     // memcpy
+#include <cstdlib>     // strtod, strtof, strtold, abs
+#include <string>      // string
+#include <vector>      // vector
+#include <string_view> // string_view
+#include <charconv>    // from_chars, to_chars
+#include <algorithm>   // max, copy, fill_n, reverse
+#include <limits>      // numeric_limits
+#include <type_traits> // is_same_v
+#include <cmath>       // ldexp
+#include <cfloat>      // LDBL_MANT_DIG
+#include <atomic>      // atomic
+#include <memory>      // unique_ptr
+
+#include "hex.hpp"     // hex::Scan, HEX_HAS_X86 and the x86 intrinsics
+
+namespace ieee754
+{
+    /*
+     * Every byte value spelled out as 8 '0' or '1' chars, most significant bit
+     * first.
+     */
+    struct ByteBitsTable
+    {
+        char chars[256][8];
+
+        constexpr ByteBitsTable()
+            : chars()
+        {
+            for(unsigned byte = 0; byte < 256; byte++)
+            {
+                for(unsigned bit = 0; bit < 8; bit++)
+                {
+                    chars[byte][bit] = (byte & (0x80u >> bit)) ? '1' : '0';
+                }
+            }
+        }
+    };
+
+    inline constexpr ByteBitsTable byteBits;
+
+    /*
+     * Unsigned integer wide enough for the bits of every supported format.
+     */
+    using Bits = unsigned __int128;
+
+    /*
+     * The supported formats. Bad is no format: a token that is not a value,
+     * or (for a forced type) going by the number of hex digits.
+     */
+    enum class Type : unsigned char
+    {
+        Bad,
+        Half,
+        BFloat16,
+        Float,
+        Double,
+        Extended,
+        Quad,
+    };
+
+    /*
+     * Tags for the formats without a C++ type of their own. long double is
+     * x87 extended precision on some machines and binary128 or double on
+     * others, so those two get tags as well.
+     */
+    struct Half {};     // IEEE 754 binary16
+    struct BFloat16 {}; // bfloat16, the top half of a float
+    struct Extended {}; // x87 80 bit extended precision
+    struct Quad {};     // IEEE 754 binary128
+
+    /*
+     * Turns the fields of a binary floating point value with an implicit
+     * integer bit into a Value, with ldexp. Exact as long as Value has enough
+     * precision and range.
+     */
+    template<typename Value>
+    inline Value ComputeValue(bool negative, unsigned exponent, Bits fraction,
+                              unsigned exponentBits, unsigned fractionBits)
+    {
+        const unsigned maxExponent = (1u << exponentBits) - 1;
+        const int      bias        = (1 << (exponentBits - 1)) - 1;
+        Value          magnitude;
+
+        if(exponent == maxExponent)
+        {
+            magnitude = (fraction == 0) ? std::numeric_limits<Value>::infinity()
+                : std::numeric_limits<Value>::quiet_NaN();
+        }
+        else
+        {
+            // subnormals share the smallest normal exponent.
+            int scale = ((exponent == 0) ? 1 : static_cast<int>(exponent))
+                - bias - static_cast<int>(fractionBits);
+
+            if(exponent != 0)
+            {
+                fraction |= Bits(1) << fractionBits;
+            }
+
+            magnitude = std::ldexp(static_cast<Value>(fraction), scale);
+        }
+
+        return negative ? -magnitude : magnitude;
+    }
+
+    /*
+     * Compile time description of each format: field widths, whether the
+     * significand's integer bit is stored (x87), the type that holds its
+     * bits, and the type its value is printed through.
+     */
+    template<typename T>
+    struct FormatTraits;
+
+    template<>
+    struct FormatTraits<Half>
+    {
+        using Storage = std::uint16_t;
+        using Value   = float;
+
+        static constexpr unsigned exponentBits       = 5;
+        static constexpr unsigned mantissaBits       = 10;
+        static constexpr bool     explicitIntegerBit = false;
+        static constexpr char     name[]             = "half";
+        static constexpr Type     type               = Type::Half;
+
+        static Value ToValue(Storage bits)
+        {
+            return ComputeValue<Value>(bits >> 15, (bits >> mantissaBits) & 0x1F,
+                                         bits & 0x3FF, exponentBits, mantissaBits);
+        }
+    };
+
+    template<>
+    struct FormatTraits<BFloat16>
+    {
+        using Storage = std::uint16_t;
+        using Value   = float;
+
+        static constexpr unsigned exponentBits       = 8;
+        static constexpr unsigned mantissaBits       = 7;
+        static constexpr bool     explicitIntegerBit = false;
+        static constexpr char     name[]             = "bfloat16";
+        static constexpr Type     type               = Type::BFloat16;
+
+        static Value ToValue(Storage bits)
+        {
+            std::uint32_t asFloat = static_cast<std::uint32_t>(bits) << 16;
+            Value         value;
+
+            std::memcpy(&value, &asFloat, sizeof(value));
+            return value;
+        }
+    };
+
+    template<>
+    struct FormatTraits<float>
+    {
+        using Storage = std::uint32_t;
+        using Value   = float;
+
+        static constexpr unsigned exponentBits       = 8;
+        static constexpr unsigned mantissaBits       = 23;
+        static constexpr bool     explicitIntegerBit = false;
+        static constexpr char     name[]             = "float";
+        static constexpr Type     type               = Type::Float;
+
+        static Value ToValue(Storage bits)
+        {
+            Value value;
+
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+    };
+
+    template<>
+    struct FormatTraits<double>
+    {
+        using Storage = std::uint64_t;
+        using Value   = double;
+
+        static constexpr unsigned exponentBits       = 11;
+        static constexpr unsigned mantissaBits       = 52;
+        static constexpr bool     explicitIntegerBit = false;
+        static constexpr char     name[]             = "double";
+        static constexpr Type     type               = Type::Double;
+
+        static Value ToValue(Storage bits)
+        {
+            Value value;
+
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+    };
+
+    template<>
+    struct FormatTraits<Extended>
+    {
+        using Storage = Bits;
+        using Value   = long double;
+
+        static constexpr unsigned exponentBits       = 15;
+        static constexpr unsigned mantissaBits       = 64;
+        static constexpr bool     explicitIntegerBit = true;
+        static constexpr char     name[]             = "x87";
+        static constexpr Type     type               = Type::Extended;
+
+        static Value ToValue(Storage bits)
+        {
+#if (LDBL_MANT_DIG == 64) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+            // the low 10 bytes are the x87 register image.
+            Value value = 0;
+
+            std::memcpy(&value, &bits, 10);
+            return value;
+#else
+            // the integer bit is taken to match the exponent.
+            return ComputeValue<Value>((bits >> 79) & 1, (bits >> mantissaBits) & 0x7FFF,
+                                         bits & ~(std::uint64_t(1) << 63) & ~std::uint64_t(0),
+                                         exponentBits, mantissaBits - 1);
+#endif
+        }
+    };
+
+    template<>
+    struct FormatTraits<Quad>
+    {
+        using Storage = Bits;
+        using Value   = long double; // so binary128 is rounded unless long double is binary128
+
+        static constexpr unsigned exponentBits       = 15;
+        static constexpr unsigned mantissaBits       = 112;
+        static constexpr bool     explicitIntegerBit = false;
+        static constexpr char     name[]             = "binary128";
+        static constexpr Type     type               = Type::Quad;
+
+        static Value ToValue(Storage bits)
+        {
+#if LDBL_MANT_DIG == 113
+            Value value;
+
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+#elif defined(__SIZEOF_FLOAT128__)
+            __float128 value;
+
+            std::memcpy(&value, &bits, sizeof(value));
+            return static_cast<Value>(value);
+#else
+            return ComputeValue<Value>((bits >> 127) & 1, (bits >> mantissaBits) & 0x7FFF,
+                                         bits & ((Bits(1) << mantissaBits) - 1),
+                                         exponentBits, mantissaBits);
+#endif
+        }
+    };
+
+    /*
+     * The classes of a float, in the order of floatClassNames.
+     */
+    enum class FloatClass : unsigned char
+    {
+        Zero,
+        Subnormal,
+        Normal,
+        Infinity,
+        NaN,
+    };
+
+    inline constexpr unsigned numFloatClasses = 5;
+
+    inline constexpr const char *floatClassNames[numFloatClasses] =
+    {
+        "Zero", "Subnormal", "Normal", "Infinity", "NaN",
+    };
+
+    /*
+     * Representation of an IEEE 754 style float of any of the formats that
+     * have FormatTraits. Everything about the layout is known at compile time.
+     */
+    template<typename T>
+    class IEEE754Float
+    {
+    public:
+        using Traits  = FormatTraits<T>;
+        using Storage = typename Traits::Storage;
+        using Value   = typename Traits::Value;
+
+        // number of exponent bits, and of stored mantissa (fraction) bits.
+        static constexpr unsigned exponentBits = Traits::exponentBits;
+        static constexpr unsigned mantissaBits = Traits::mantissaBits;
+
+        // number of bits in the float type.
+        static constexpr unsigned numBits = 1 + exponentBits + mantissaBits;
+
+    private:
+        static constexpr unsigned maxExponent  = (1u << exponentBits) - 1;
+        // mantissa bits after the binary point.
+        static constexpr unsigned fractionBits = mantissaBits
+            - (Traits::explicitIntegerBit ? 1 : 0);
+
+        static_assert((numBits % 8) == 0, "formats are whole bytes");
+
+        Storage _bits = 0;
+
+    public:
+        /* Writes the _float's bits (1's or 0's), most significant first, to
+           out. out must have room for numBits chars. */
+        void GetBinary(char *out) const
+        {
+            constexpr unsigned numBytes = numBits / 8;
+
+            for(unsigned i = 0; i < numBytes; i++)
+            {
+                unsigned byte = (_bits >> ((numBytes - 1 - i) * 8)) & 0xFF;
+
+                std::memcpy(out + (i * 8), byteBits.chars[byte], 8);
+            }
+        }
+
+        /* Converts a hex string (without the "0x" prefix) that has already
+           been validated. */
+        static IEEE754Float<T> HexStrToIEEEFloat(const std::string_view hex)
+        {
+            IEEE754Float<T>    floatVal;
+            hex::ScanResult    scan = hex::Scan(hex);
+
+            floatVal = (Bits(scan.high) << 64) | scan.value;
+
+            return floatVal;
+        }
+
+        
+        IEEE754Float() = default;
+        
+        IEEE754Float(unsigned i)
+            : _bits(i)
+        {
+        }
+
+        IEEE754Float<T> operator=(Bits i)
+        {
+            _bits = static_cast<Storage>(i);
+            return *this;
+        }
+
+        FloatClass GetFloatClass() const
+        {
+            const unsigned exponent = GetExponentBits();
+            const Bits     mantissa = GetMantissaBits();
+            const Bits     fraction = mantissa & ((Bits(1) << fractionBits) - 1);
+            // x87 normals and infinities must have their integer bit set.
+            const bool     integerBitOk = !Traits::explicitIntegerBit
+                || ((mantissa >> fractionBits) & 1);
+
+            if(exponent == maxExponent)
+            {
+                return ((fraction == 0) && integerBitOk) ? FloatClass::Infinity
+                    : FloatClass::NaN;
+            }
+            else if(exponent == 0)
+            {
+                return (mantissa == 0) ? FloatClass::Zero : FloatClass::Subnormal;
+            }
+
+            return integerBitOk ? FloatClass::Normal : FloatClass::NaN;
+        }
+
+        const char *GetFloatClassification() const
+        {
+            return floatClassNames[static_cast<unsigned>(GetFloatClass())];
+        }
+
+        const char *GetFloatSign() const
+        {
+            if (GetSignBit())
+                return "Negative";
+            else
+                return "Positive";
+        }
+        
+        /* Writes the table of the bits to out, which has Write, Put and Fill
+           like float's OutputBuffer. */
+        template<typename Out>
+        void PrintFormattedOutput(Out &out) const
+        {
+            constexpr char columnStr[] = "||";
+            constexpr char signStr[]   = " Sign";
+            constexpr char expStr[]    = "Exponent";
+            constexpr char mantStr[]   = "Mantissa";
+
+            // columns are as wide as their bits, or their names.
+            constexpr unsigned exponentWidth = std::max<unsigned>(exponentBits,
+                                                                  sizeof(expStr) - 1);
+            constexpr unsigned mantissaWidth = std::max<unsigned>(mantissaBits,
+                                                                  sizeof(mantStr) - 1);
+            constexpr unsigned tableSize     = (4 * (sizeof(columnStr) - 1))
+                + (sizeof(signStr) - 1) + exponentWidth + mantissaWidth + 1;
+
+            // the top and bottom of the table
+            static const std::string ends = std::string(tableSize - 1, '=') + '\n';
+
+            // column names, right aligned
+            auto column = [&](const std::string_view name, unsigned width)
+                          {
+                              std::string padded;
+
+                              if(width > name.size())
+                              {
+                                  padded.assign(width - name.size(), ' ');
+                              }
+
+                              return padded.append(name).append(columnStr);
+                          };
+            static const std::string header = ends + columnStr + signStr
+                + columnStr + column(expStr, exponentWidth)
+                + column(mantStr, mantissaWidth) + '\n';
+
+            char bin[numBits];
+
+            GetBinary(bin);
+
+            out.Write(header);
+
+            out.Write(columnStr, sizeof(columnStr) - 1);
+            out.Fill(' ', sizeof(signStr) - 2);
+            out.Put(bin[0]);
+            out.Write(columnStr, sizeof(columnStr) - 1);
+            // print the string's exponent [1, exponentsize]
+            out.Fill(' ', exponentWidth - exponentBits);
+            out.Write(bin + 1, exponentBits);
+            out.Write(columnStr, sizeof(columnStr) - 1);
+            // print the mantissa (fraction) (exponentsize, end]
+            out.Fill(' ', mantissaWidth - mantissaBits);
+            out.Write(bin + exponentBits + 1, mantissaBits);
+            out.Write(columnStr, sizeof(columnStr) - 1);
+            out.Put('\n');
+
+            out.Write(ends);
+
+            out.Write("Class: ");
+            out.Write(GetFloatSign());
+            out.Put(' ');
+            out.Write(GetFloatClassification());
+            out.Put('\n');
+        }
+
+        Value GetIEEEFloat() const
+        {
+            return Traits::ToValue(_bits);
+        }
+
+        Bits GetBits() const
+        {
+            return _bits;
+        }
+
+        unsigned GetSignBit() const
+        {
+            return (_bits >> (numBits - 1)) & 1;
+        }
+
+        /* The biased exponent, as stored. */
+        unsigned GetExponentBits() const
+        {
+            return (_bits >> mantissaBits) & maxExponent;
+        }
+
+        /* The unbiased exponent. Subnormals (and zero) have the smallest
+           normal exponent. */
+        int GetExponent() const
+        {
+            constexpr int bias = static_cast<int>(maxExponent / 2);
+
+            return std::max<int>(GetExponentBits(), 1) - bias;
+        }
+
+        /* The stored mantissa bits, with x87's integer bit. */
+        Bits GetMantissaBits() const
+        {
+            return _bits & ((Bits(1) << mantissaBits) - 1);
+        }
+
+        ~IEEE754Float() = default;
+
+    };
+
+    // aliases
+    using Float  = IEEE754Float<float>;
+    using Double = IEEE754Float<double>;
+
+    /*
+     * Number of hex digits of each type of value, 0 for anything else.
+     */
+    constexpr unsigned HexDigitsOf(Type type)
+    {
+        switch(type)
+        {
+        case Type::Half:
+            return IEEE754Float<Half>::numBits / 4;
+        case Type::BFloat16:
+            return IEEE754Float<BFloat16>::numBits / 4;
+        case Type::Float:
+            return IEEE754Float<float>::numBits / 4;
+        case Type::Double:
+            return IEEE754Float<double>::numBits / 4;
+        case Type::Extended:
+            return IEEE754Float<Extended>::numBits / 4;
+        case Type::Quad:
+            return IEEE754Float<Quad>::numBits / 4;
+        default:
+            return 0;
+        }
+    }
+
+    /*
+     * Which values are printed, from --only. A value is printed if its class,
+     * its sign and its unbiased exponent are all allowed.
+     */
+    struct Filter
+    {
+        unsigned classes     = 0x1F; // bit per FloatClass
+        unsigned signs       = 0x3;  // bit 0 positive, bit 1 negative
+        int      minExponent = std::numeric_limits<int>::min();
+        int      maxExponent = std::numeric_limits<int>::max();
+    };
+
+    /*
+     * Returns true if filter drops anything.
+     */
+    inline bool IsFiltering(const Filter &filter)
+    {
+        const Filter none;
+
+        return (filter.classes != none.classes) || (filter.signs != none.signs)
+            || (filter.minExponent != none.minExponent)
+            || (filter.maxExponent != none.maxExponent);
+    }
+
+    /*
+     * Returns true if filter lets value through. Only looks at its bits.
+     */
+    template<typename T>
+    inline bool Passes(const Filter &filter, const IEEE754Float<T> &value)
+    {
+        const int exponent = value.GetExponent();
+
+        return ((filter.classes >> static_cast<unsigned>(value.GetFloatClass())) & 1)
+            && ((filter.signs >> value.GetSignBit()) & 1)
+            && (exponent >= filter.minExponent) && (exponent <= filter.maxExponent);
+    }
+
+    /*
+     * How many values of T apart a and b are: the number of steps to the next
+     * float it takes to get from one to the other. The two zeros are one
+     * apart. Meaningless if either is a NaN.
+     */
+    template<typename T>
+    inline Bits UlpDistance(const IEEE754Float<T> &a, const IEEE754Float<T> &b)
+    {
+        constexpr Bits signBit = Bits(1) << (IEEE754Float<T>::numBits - 1);
+
+        // sign and magnitude onto one line, the negatives below the positives.
+        auto ordered = [](Bits bits)
+                       {
+                           return (bits & signBit) ? (signBit - 1) - (bits & ~signBit)
+                               : signBit + bits;
+                       };
+        const Bits x = ordered(a.GetBits());
+        const Bits y = ordered(b.GetBits());
+
+        return (x > y) ? (x - y) : (y - x);
+    }
+
+    // chars FormatDecimal may need besides the precision's digits: sign,
+    // point, "0.000" and the exponent. binary128's shortest round trip
+    // form takes up to 36 digits and a 4 digit exponent.
+    inline constexpr std::size_t decimalExtraChars = 48;
+
+    // the most significant digits a value of any type has, those of
+    // binary128's (2^113 - 1) * 2^-16494. Higher precisions only add the
+    // zeros "%g" drops, so they are cut to it.
+    inline constexpr unsigned maxDecimalPrecision = 11563;
+
+    /*
+     * Writes value to dest, which has room for precision + decimalExtraChars
+     * chars, and returns the end of what was written. With roundTrip, the
+     * shortest string that reads back as the same T is written; otherwise
+     * value is printed like printf's "%.*g" with precision. Uses
+     * std::to_chars, so no locale is involved.
+     */
+    template<typename T>
+    inline char *FormatDecimal(char *dest, T value, bool roundTrip,
+                               unsigned precision)
+    {
+        if(roundTrip)
+        {
+            return std::to_chars(dest, dest + decimalExtraChars, value).ptr;
+        }
+
+        return std::to_chars(dest, dest + precision + decimalExtraChars, value,
+                             std::chars_format::general, precision).ptr;
+    }
+
+    /*
+     * The decimal strings of all 65536 values of a 16 bit format at one
+     * precision (or in the round trip form), so that formatting a half or
+     * bfloat16 is a copy. An entry is formatted the first time its bits are
+     * seen, and the table's memory is only touched then, so values that never
+     * show up cost nothing. Tables are shared by all threads: an entry is
+     * claimed by the first thread to format it and published once written;
+     * until then, other threads format it themselves.
+     */
+    template<typename T>
+    class DecimalTable
+    {
+    private:
+        using Storage = typename FormatTraits<T>::Storage;
+
+        static_assert(IEEE754Float<T>::numBits == 16, "tables are for 16 bit formats");
+
+        static constexpr std::size_t  numEntries = std::size_t(1) << 16;
+        static constexpr unsigned     maxChars   = 30; // of an entry's text
+        // states of an entry
+        static constexpr std::uint8_t empty      = 0;
+        static constexpr std::uint8_t writing    = 1;
+        static constexpr std::uint8_t ready      = 2;
+
+        struct Entry
+        {
+            std::uint8_t state;
+            std::uint8_t length;
+            char         text[maxChars];
+        };
+
+        Entry         *_entries;
+        const bool     _roundTrip;
+        const unsigned _precision;
+
+        DecimalTable(bool roundTrip, unsigned precision)
+            // calloc, so that the pages are only mapped when written.
+            : _entries(static_cast<Entry *>(std::calloc(numEntries, sizeof(Entry)))),
+              _roundTrip(roundTrip), _precision(precision)
+        {
+        }
+
+    public:
+        // the highest precision with a table: its digits, a sign, a point
+        // and "0.000" or a 4 char exponent fit in an entry.
+        static constexpr unsigned maxPrecision = maxChars - 6;
+
+        DecimalTable(const DecimalTable &) = delete;
+        DecimalTable &operator=(const DecimalTable &) = delete;
+
+        ~DecimalTable()
+        {
+            std::free(_entries);
+        }
+
+        /* The table for roundTrip and precision, made the first time it is
+           asked for, or nullptr if precision is above maxPrecision. */
+        static DecimalTable *Get(bool roundTrip, unsigned precision)
+        {
+            // [0] is the round trip table, [p + 1] precision p's.
+            struct Tables
+            {
+                std::atomic<DecimalTable *> slots[maxPrecision + 2] = {};
+
+                ~Tables()
+                {
+                    for(std::atomic<DecimalTable *> &slot : slots)
+                    {
+                        delete slot.load();
+                    }
+                }
+            };
+            static Tables tables;
+
+            if(!roundTrip && (precision > maxPrecision))
+            {
+                return nullptr;
+            }
+
+            std::atomic<DecimalTable *> &slot  = tables.slots[roundTrip ? 0 : precision + 1];
+            DecimalTable                *table = slot.load(std::memory_order_acquire);
+
+            if(table == nullptr)
+            {
+                std::unique_ptr<DecimalTable> made(new DecimalTable(roundTrip, precision));
+
+                if(made->_entries == nullptr)
+                {
+                    return nullptr;
+                }
+                // another thread may have made it first.
+                if(slot.compare_exchange_strong(table, made.get(), std::memory_order_acq_rel))
+                {
+                    table = made.release();
+                }
+            }
+
+            return table;
+        }
+
+        /* Writes the decimal value of bits to dest, like FormatDecimal with
+           the table's precision, and returns the end of what was written. */
+        char *Format(char *dest, Storage bits)
+        {
+            Entry       &entry = _entries[bits];
+            std::uint8_t state = __atomic_load_n(&entry.state, __ATOMIC_ACQUIRE);
+
+            if(state == ready)
+            {
+                // dest has room for decimalExtraChars, more than maxChars.
+                std::memcpy(dest, entry.text, maxChars);
+                return dest + entry.length;
+            }
+
+            const IEEE754Float<T> value(bits);
+            char                 *end    = FormatDecimal(dest, value.GetIEEEFloat(),
+                                                         _roundTrip, _precision);
+            const std::size_t     length = end - dest;
+
+            if((state == empty) && (length <= maxChars)
+               && __atomic_compare_exchange_n(&entry.state, &state, writing, false,
+                                              __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            {
+                std::memcpy(entry.text, dest, length);
+                entry.length = static_cast<std::uint8_t>(length);
+                __atomic_store_n(&entry.state, ready, __ATOMIC_RELEASE);
+            }
+
+            return end;
+        }
+    };
+
+    /*
+     * Writes value in decimal to dest, which has room for 40 chars, and returns
+     * the end of what was written. std::to_chars has no 128 bit overload.
+     */
+    inline char *FormatUnsigned(char *dest, Bits value)
+    {
+        constexpr std::uint64_t tenTo19 = 10000000000000000000u;
+
+        if(value <= ~std::uint64_t(0))
+        {
+            return std::to_chars(dest, dest + 20, static_cast<std::uint64_t>(value)).ptr;
+        }
+
+        // the low 19 digits, zero padded, after the rest.
+        char         *end = FormatUnsigned(dest, value / tenTo19);
+        std::uint64_t low = value % tenTo19;
+
+        for(int i = 18; i >= 0; i--)
+        {
+            end[i] = '0' + (low % 10);
+            low /= 10;
+        }
+
+        return end + 19;
+    }
+
+    namespace detail
+    {
+        /* Writes 0.digits × 10^point like printf's "%.*e" with no trailing
+           zeros. */
+        inline char *WriteScientific(char *dest, std::string_view digits, int point)
+        {
+            const int exponent = point - 1;
+
+            *dest++ = digits[0];
+            if(digits.size() > 1)
+            {
+                *dest++ = '.';
+                dest    = std::copy(digits.begin() + 1, digits.end(), dest);
+            }
+            *dest++ = 'e';
+            *dest++ = (exponent < 0) ? '-' : '+';
+            if((exponent > -10) && (exponent < 10))
+            {
+                *dest++ = '0';
+            }
+
+            return std::to_chars(dest, dest + 8, (exponent < 0) ? -exponent : exponent).ptr;
+        }
+
+        /* The same, like printf's "%f" with no trailing zeros. */
+        inline char *WriteFixed(char *dest, std::string_view digits, int point)
+        {
+            const int size = static_cast<int>(digits.size());
+
+            if(point <= 0)
+            {
+                *dest++ = '0';
+                *dest++ = '.';
+                dest    = std::fill_n(dest, -point, '0');
+                return std::copy(digits.begin(), digits.end(), dest);
+            }
+            else if(point >= size)
+            {
+                dest = std::copy(digits.begin(), digits.end(), dest);
+                return std::fill_n(dest, point - size, '0');
+            }
+
+            dest    = std::copy(digits.begin(), digits.begin() + point, dest);
+            *dest++ = '.';
+            return std::copy(digits.begin() + point, digits.end(), dest);
+        }
+
+        /* The lengths WriteFixed and WriteScientific would write. */
+        inline std::size_t FixedLength(std::string_view digits, int point)
+        {
+            const int size = static_cast<int>(digits.size());
+
+            return (point <= 0) ? (2 - point + size) : (point >= size) ? point : (size + 1);
+        }
+
+        inline std::size_t ScientificLength(std::string_view digits, int point)
+        {
+            const int exponent = std::abs(point - 1);
+
+            return digits.size() + ((digits.size() > 1) ? 1 : 0) + 2
+                + ((exponent >= 1000) ? 4 : (exponent >= 100) ? 3 : 2);
+        }
+
+        /*
+         * A binary fraction with a 256 bit mantissa, for scaling binary128
+         * values by powers of ten: words (least significant first, the top
+         * bit set) × 2^exponent. Products are cut to 256 bits, so a power of
+         * ten made of 13 of them is off by less than 2^-240 of itself.
+         */
+        struct Wide
+        {
+            std::uint64_t words[4];
+            int           exponent;
+        };
+
+        /* a × b, cut to 256 bits. */
+        inline Wide Multiply(const Wide &a, const Wide &b)
+        {
+            std::uint64_t product[8] = {};
+            Wide          result;
+
+            for(unsigned i = 0; i < 4; i++)
+            {
+                Bits carry = 0;
+
+                for(unsigned j = 0; j < 4; j++)
+                {
+                    carry         += Bits(a.words[i]) * b.words[j] + product[i + j];
+                    product[i + j] = static_cast<std::uint64_t>(carry);
+                    carry        >>= 64;
+                }
+                product[i + 4] = static_cast<std::uint64_t>(carry);
+            }
+
+            result.exponent = a.exponent + b.exponent + 256;
+            // both top bits are set, so the product's top bit is one of its top two.
+            if((product[7] >> 63) == 0)
+            {
+                for(unsigned i = 7; i >= 4; i--)
+                {
+                    product[i] = (product[i] << 1) | (product[i - 1] >> 63);
+                }
+                result.exponent--;
+            }
+            std::copy(product + 4, product + 8, result.words);
+
+            return result;
+        }
+
+        /*
+         * 10^power, from 10^(2^i) and 10^-(2^i), which are made once by
+         * squaring 10 and 0.1. power is below 2^13 in size, as binary128
+         * values are from 10^-4966 to 10^4933.
+         */
+        inline Wide PowerOfTen(int power)
+        {
+            constexpr unsigned numSquares = 13;
+
+            struct Squares
+            {
+                Wide up[numSquares];
+                Wide down[numSquares];
+
+                Squares()
+                {
+                    // 0.1 is 2^259 / 10 × 2^-259, by long division.
+                    Bits remainder = 8;
+
+                    up[0]   = { { 0, 0, 0, std::uint64_t(10) << 60 }, -252 };
+                    down[0] = { {}, -259 };
+                    for(unsigned i = 4; i-- > 0;)
+                    {
+                        const Bits dividend = remainder << 64;
+
+                        down[0].words[i] = static_cast<std::uint64_t>(dividend / 10);
+                        remainder        = dividend % 10;
+                    }
+
+                    for(unsigned i = 1; i < numSquares; i++)
+                    {
+                        up[i]   = Multiply(up[i - 1], up[i - 1]);
+                        down[i] = Multiply(down[i - 1], down[i - 1]);
+                    }
+                }
+            };
+            static const Squares squares;
+
+            const unsigned size   = static_cast<unsigned>(std::abs(power));
+            const Wide    *powers = (power < 0) ? squares.down : squares.up;
+            Wide           result = { { 0, 0, 0, std::uint64_t(1) << 63 }, -255 };
+
+            for(unsigned i = 0; i < numSquares; i++)
+            {
+                if((size >> i) & 1)
+                {
+                    result = Multiply(result, powers[i]);
+                }
+            }
+
+            return result;
+        }
+
+        /* 10^0 to 10^38, all that fit Bits. */
+        struct TensTable
+        {
+            Bits powers[39];
+
+            constexpr TensTable()
+                : powers()
+            {
+                powers[0] = 1;
+                for(unsigned i = 1; i < 39; i++)
+                {
+                    powers[i] = powers[i - 1] * 10;
+                }
+            }
+        };
+        inline constexpr TensTable tens;
+
+        /*
+         * n × 2^exponent × 10^power, which must be below 2^127, as its whole
+         * part and the top 64 bits of its fraction. When it is exact, the
+         * lowest bit of fraction is also set if any bits below it are;
+         * otherwise it is from tens (the Wide 10^power), and may be off by
+         * up to 2^-63.
+         */
+        struct Scaled
+        {
+            Bits          whole;
+            std::uint64_t fraction;
+            bool          exact;
+        };
+
+        /* Sets whole to n × 2^exponent × 10^power, and returns true, if that
+           is a whole number below 2^127. n must not be 0. */
+        inline bool ScaleExactly(Bits n, int exponent, int power, Bits &whole)
+        {
+            for(; (n & 1) == 0; n >>= 1)
+            {
+                exponent++;
+            }
+
+            // an odd number over a power of 2 is not whole.
+            exponent += power;
+            if(exponent < 0)
+            {
+                return false;
+            }
+
+            for(; power < 0; power++)
+            {
+                if((n % 5) != 0)
+                {
+                    return false;
+                }
+                n /= 5;
+            }
+            for(; power > 0; power--)
+            {
+                if(__builtin_mul_overflow(n, Bits(5), &n))
+                {
+                    return false;
+                }
+            }
+
+            if((exponent >= 127) || ((n >> (127 - exponent)) != 0))
+            {
+                return false;
+            }
+
+            whole = n << exponent;
+            return true;
+        }
+
+        /*
+         * A big number for ScaleSlowly: base 2^32, least significant limb
+         * first, with no leading zero limbs.
+         */
+        using Limbs = std::vector<std::uint32_t>;
+
+        /* n × factor. */
+        inline void Multiply(Limbs &n, std::uint32_t factor)
+        {
+            std::uint64_t carry = 0;
+
+            for(std::uint32_t &limb : n)
+            {
+                carry += std::uint64_t(limb) * factor;
+                limb   = static_cast<std::uint32_t>(carry);
+                carry >>= 32;
+            }
+            if(carry != 0)
+            {
+                n.push_back(static_cast<std::uint32_t>(carry));
+            }
+        }
+
+        /* n × 2^bits. */
+        inline void ShiftLeft(Limbs &n, unsigned bits)
+        {
+            if(((bits % 32) != 0) && !n.empty())
+            {
+                std::uint32_t carry = 0;
+
+                for(std::uint32_t &limb : n)
+                {
+                    const std::uint32_t next = limb >> (32 - (bits % 32));
+
+                    limb  = (limb << (bits % 32)) | carry;
+                    carry = next;
+                }
+                if(carry != 0)
+                {
+                    n.push_back(carry);
+                }
+            }
+            n.insert(n.begin(), bits / 32, 0);
+        }
+
+        /* n / 2, rounded down. */
+        inline void Halve(Limbs &n)
+        {
+            for(std::size_t i = 0; i < n.size(); i++)
+            {
+                n[i] = (n[i] >> 1) | ((i + 1 < n.size()) ? (n[i + 1] << 31) : 0);
+            }
+            if(!n.empty() && (n.back() == 0))
+            {
+                n.pop_back();
+            }
+        }
+
+        inline unsigned BitWidth(const Limbs &n)
+        {
+            return n.empty() ? 0 : static_cast<unsigned>((n.size() * 32) - __builtin_clz(n.back()));
+        }
+
+        /* Less than 0, 0 or more than 0 as a is below, at or above b. */
+        inline int Compare(const Limbs &a, const Limbs &b)
+        {
+            if(a.size() != b.size())
+            {
+                return (a.size() < b.size()) ? -1 : 1;
+            }
+
+            for(std::size_t i = a.size(); i-- > 0;)
+            {
+                if(a[i] != b[i])
+                {
+                    return (a[i] < b[i]) ? -1 : 1;
+                }
+            }
+
+            return 0;
+        }
+
+        /* a - b, b not above a. */
+        inline void Subtract(Limbs &a, const Limbs &b)
+        {
+            std::int64_t borrow = 0;
+
+            for(std::size_t i = 0; i < a.size(); i++)
+            {
+                borrow += std::int64_t(a[i]) - ((i < b.size()) ? b[i] : 0);
+                a[i]    = static_cast<std::uint32_t>(borrow);
+                borrow  = (borrow < 0) ? -1 : 0;
+            }
+            while(!a.empty() && (a.back() == 0))
+            {
+                a.pop_back();
+            }
+        }
+
+        /*
+         * Scale, worked out exactly as a fraction of big numbers, n ×
+         * 2^(exponent + 64) × 10^power over 1, with the twos and fives of
+         * negative powers moved below, divided bit by bit. Slow, as the big
+         * numbers take up to 16494 bits, so it is only used for the few
+         * values too close to a rounding boundary for the Wide powers of
+         * ten to tell which way they go.
+         */
+        inline Scaled ScaleSlowly(Bits n, int exponent, int power)
+        {
+            // 5^13, the most fives that fit a limb.
+            constexpr std::uint32_t fives = 1220703125;
+
+            const int     twos        = exponent + power + 64;
+            Limbs         numerator   = { static_cast<std::uint32_t>(n),
+                                          static_cast<std::uint32_t>(n >> 32),
+                                          static_cast<std::uint32_t>(n >> 64),
+                                          static_cast<std::uint32_t>(n >> 96) };
+            Limbs         denominator = { 1 };
+            std::uint64_t quotient[3] = {};
+            Scaled        scaled      = {};
+
+            while(numerator.back() == 0)
+            {
+                numerator.pop_back();
+            }
+
+            for(int left = std::abs(power); left > 0; left -= 13)
+            {
+                Limbs &side = (power >= 0) ? numerator : denominator;
+
+                if(left >= 13)
+                {
+                    Multiply(side, fives);
+                }
+                else
+                {
+                    for(int i = 0; i < left; i++)
+                    {
+                        Multiply(side, 5);
+                    }
+                }
+            }
+            ShiftLeft((twos >= 0) ? numerator : denominator, static_cast<unsigned>(std::abs(twos)));
+
+            // the quotient is below 2^191, so the denominator is shifted up
+            // at most that far.
+            const int shift = std::max(static_cast<int>(BitWidth(numerator))
+                                       - static_cast<int>(BitWidth(denominator)), 0);
+
+            ShiftLeft(denominator, static_cast<unsigned>(shift));
+            for(int bit = shift; bit >= 0; bit--)
+            {
+                if(Compare(numerator, denominator) >= 0)
+                {
+                    Subtract(numerator, denominator);
+                    quotient[bit / 64] |= std::uint64_t(1) << (bit % 64);
+                }
+                Halve(denominator);
+            }
+
+            scaled.whole    = (Bits(quotient[2]) << 64) | quotient[1];
+            scaled.fraction = quotient[0] | (numerator.empty() ? 0 : 1);
+            scaled.exact    = true;
+            return scaled;
+        }
+
+        /* n × 2^exponent × 10^power, from the Wide ten, or exactly if
+           slowly is true. */
+        inline Scaled Scale(Bits n, int exponent, int power, const Wide &ten, bool slowly)
+        {
+            Scaled scaled = {};
+
+            if(ScaleExactly(n, exponent, power, scaled.whole))
+            {
+                scaled.exact = true;
+                return scaled;
+            }
+            else if(slowly)
+            {
+                return ScaleSlowly(n, exponent, power);
+            }
+
+            // n × ten's mantissa is 384 bits, the value is it × 2^shift, and
+            // the bits from 2^-64 up are below 2^191.
+            const std::uint64_t halves[2] = { static_cast<std::uint64_t>(n),
+                                              static_cast<std::uint64_t>(n >> 64) };
+            const unsigned      shift     = static_cast<unsigned>(-(ten.exponent + exponent) - 64);
+            std::uint64_t       product[6] = {};
+            std::uint64_t       window[3];
+
+            for(unsigned i = 0; i < 2; i++)
+            {
+                Bits carry = 0;
+
+                for(unsigned j = 0; j < 4; j++)
+                {
+                    carry         += Bits(halves[i]) * ten.words[j] + product[i + j];
+                    product[i + j] = static_cast<std::uint64_t>(carry);
+                    carry        >>= 64;
+                }
+                product[i + 4] = static_cast<std::uint64_t>(carry);
+            }
+
+            auto word = [&](unsigned index) { return (index < 6) ? product[index] : 0; };
+
+            for(unsigned i = 0; i < 3; i++)
+            {
+                const unsigned bit = shift + (i * 64);
+
+                window[i] = word(bit / 64) >> (bit % 64);
+                if((bit % 64) != 0)
+                {
+                    window[i] |= word((bit / 64) + 1) << (64 - (bit % 64));
+                }
+            }
+
+            scaled.whole    = (Bits(window[2]) << 64) | window[1];
+            scaled.fraction = window[0];
+            return scaled;
+        }
+
+        // what Compare returns when scaled is too close to the boundary to tell.
+        constexpr int unsure = 2;
+
+        /* -1, 0 or 1 as scaled is below, at or above boundary, or unsure. */
+        inline int Compare(const Scaled &scaled, Bits boundary)
+        {
+            // well above what scaled may be off by.
+            constexpr std::uint64_t margin = 1 << 8;
+
+            if(scaled.exact)
+            {
+                return (scaled.whole < boundary) ? -1
+                    : ((scaled.whole > boundary) || (scaled.fraction != 0));
+            }
+            else if(scaled.whole == boundary)
+            {
+                return (scaled.fraction < margin) ? unsure : 1;
+            }
+            else if(scaled.whole + 1 == boundary)
+            {
+                return (scaled.fraction > ~margin) ? unsure : -1;
+            }
+
+            return (scaled.whole < boundary) ? -1 : 1;
+        }
+
+        // the most digits QuadDigits works out, all that binary128 values
+        // need to read back.
+        constexpr unsigned quadDigits = 36;
+
+        /*
+         * The digits of mantissa × 2^exponent, a finite binary128 value that
+         * is not zero, rounded to nearest with count digits or, if count is
+         * 0, in its shortest round trip form (see FormatQuadDecimal). They
+         * go to digits, which has room for 40, with no trailing zeros, and
+         * point is set so that the value is 0.digits × 10^point. The value
+         * is scaled by a power of ten to 37 or 38 whole digits, so this is
+         * a few fixed size products, not all of its digits. count must be at
+         * most quadDigits. Returns how many digits there are, or 0 if the
+         * scaled value is too close to a rounding boundary to tell which way
+         * it goes; with slowly, it is scaled exactly, so it always tells.
+         */
+        inline std::size_t QuadDigits(char *digits, int &point, Bits mantissa, int exponent,
+                                      bool closerBelow, unsigned count, bool slowly)
+        {
+
+            const std::uint64_t upper    = static_cast<std::uint64_t>(mantissa >> 64);
+            const int           width    = (upper != 0) ? (128 - __builtin_clzll(upper))
+                : (64 - __builtin_clzll(static_cast<std::uint64_t>(mantissa)));
+            // the value is from 2^top up to 2^(top + 1), which is from
+            // 10^estimate up to 10^(estimate + 2). log10(2) is not close to
+            // a fraction with a small denominator, so a double is enough.
+            const int           top      = exponent + width - 1;
+            const int           estimate = static_cast<int>(std::floor(top * 0.30102999566398120));
+            const int           power    = 36 - estimate;
+            const Wide          ten      = PowerOfTen(power);
+            // at the scale of the halfway points below, so they share a power.
+            const Scaled        value    = Scale(mantissa * 4, exponent - 2, power, ten, slowly);
+            const int           above    = Compare(value, tens.powers[37]);
+
+            if(above == unsure)
+            {
+                return 0;
+            }
+
+            const unsigned wholeDigits = (above >= 0) ? 38 : 37;
+            unsigned       size        = 0;
+            Bits           step        = 0;
+            Bits           chosen      = 0;
+
+            // the multiples of step on either side of value, and the nearer,
+            // ties to even.
+            auto round = [&](unsigned length, Bits &down, Bits &nearest)
+                         {
+                             step = tens.powers[wholeDigits - length];
+                             down = value.whole / step * step;
+
+                             const int atDown = Compare(value, down);
+                             const int atUp   = Compare(value, down + step);
+                             const int atHalf = Compare(value, down + (step / 2));
+
+                             if((atDown == unsure) || (atUp == unsure) || (atHalf == unsure))
+                             {
+                                 return false;
+                             }
+
+                             nearest = ((atHalf < 0) || ((atHalf == 0) && (((down / step) & 1) == 0)))
+                                 ? down : (down + step);
+                             return true;
+                         };
+
+            if(count != 0)
+            {
+                Bits down;
+
+                size = count;
+                if(!round(size, down, chosen))
+                {
+                    return 0;
+                }
+            }
+            else
+            {
+                // anything strictly between the halfway points to the next
+                // values down and up reads back as value, the halfway points
+                // too if ties go to value (its mantissa is even). Below a
+                // power of 2, the next value down is half as far.
+                const Scaled low  = Scale(mantissa * 4 - (closerBelow ? 1 : 2), exponent - 2,
+                                          power, ten, slowly);
+                const Scaled high = Scale(mantissa * 4 + 2, exponent - 2, power, ten, slowly);
+                const bool   ties = (mantissa & 1) == 0;
+
+                // 1 if decimal reads back, 0 if not, or unsure.
+                auto readsBack = [&](Bits decimal)
+                                 {
+                                     const int fromLow  = Compare(low, decimal);
+                                     const int fromHigh = Compare(high, decimal);
+
+                                     if((fromLow == unsure) || (fromHigh == unsure))
+                                     {
+                                         return unsure;
+                                     }
+
+                                     return static_cast<int>((ties ? (fromLow <= 0) : (fromLow < 0))
+                                                             && (ties ? (fromHigh >= 0) : (fromHigh > 0)));
+                                 };
+
+                // 1 if the nearer or the other length digit neighbour of value
+                // reads back (set in decimal), 0 if neither does, or unsure.
+                auto neighbour = [&](unsigned length, Bits &decimal)
+                                 {
+                                     Bits down;
+                                     Bits nearest;
+
+                                     if(!round(length, down, nearest))
+                                     {
+                                         return unsure;
+                                     }
+
+                                     const Bits other = (nearest == down) ? (down + step) : down;
+
+                                     for(Bits candidate : { nearest, other })
+                                     {
+                                         if(const int result = readsBack(candidate))
+                                         {
+                                             decimal = candidate;
+                                             return result;
+                                         }
+                                     }
+
+                                     return 0;
+                                 };
+
+                // a multiple of a power of ten is a multiple of the smaller
+                // ones, so if some size digits read back, so do more; the
+                // fewest are found by bisection.
+                unsigned most = quadDigits;
+
+                for(size = 1; size < most;)
+                {
+                    const unsigned middle = (size + most) / 2;
+                    const int      result = neighbour(middle, chosen);
+
+                    if(result == unsure)
+                    {
+                        return 0;
+                    }
+                    else if(result == 1)
+                    {
+                        most = middle;
+                    }
+                    else
+                    {
+                        size = middle + 1;
+                    }
+                }
+
+                if(neighbour(size, chosen) != 1)
+                {
+                    return 0;
+                }
+            }
+
+            // value is about chosen × 10^-power.
+            char       *end     = FormatUnsigned(digits, chosen / step);
+            const int   written = static_cast<int>(end - digits);
+
+            point = written + static_cast<int>(wholeDigits - size) - power;
+            while(end[-1] == '0')
+            {
+                end--;
+            }
+
+            return end - digits;
+        }
+
+    }
+
+    /*
+     * FormatDecimal of a binary128 value that is finite and not zero, for
+     * when long double is not binary128: x87's has a 64 bit mantissa and
+     * stops at 2^-16445, so binary128 values would not read back, and the
+     * smallest would come out as 0. The round trip form is the shortest
+     * digits that read back as the same bits, and of those, the closest;
+     * it is written fixed or in exponent form, whichever is shorter, like
+     * std::to_chars does. Precisions above 36 are cut to 36.
+     */
+    inline char *FormatQuadDecimal(char *dest, const IEEE754Float<Quad> &value, bool roundTrip,
+                                   unsigned precision)
+    {
+        constexpr unsigned fractionBits = IEEE754Float<Quad>::mantissaBits;
+
+        const unsigned     exponentBits = value.GetExponentBits();
+        const Bits         fraction     = value.GetMantissaBits();
+        const Bits         mantissa     = fraction
+            | ((exponentBits != 0) ? (Bits(1) << fractionBits) : 0);
+        const int          exponent     = value.GetExponent() - static_cast<int>(fractionBits);
+        const bool         closerBelow  = (fraction == 0) && (exponentBits > 1);
+        const unsigned     count        = roundTrip ? 0
+            : std::clamp(precision, 1u, detail::quadDigits);
+        char               digits[40];
+        int                point;
+        std::size_t        size         = detail::QuadDigits(digits, point, mantissa, exponent,
+                                                             closerBelow, count, false);
+
+        if(size == 0)
+        {
+            size = detail::QuadDigits(digits, point, mantissa, exponent, closerBelow, count,
+                                      true);
+        }
+
+        if(value.GetSignBit())
+        {
+            *dest++ = '-';
+        }
+
+        const std::string_view shown(digits, size);
+
+        if(!roundTrip)
+        {
+            const int power = point - 1;
+
+            // "%g": exponent form unless the exponent is from -4 to precision - 1.
+            return ((power < -4) || (power >= static_cast<int>(count)))
+                ? detail::WriteScientific(dest, shown, point)
+                : detail::WriteFixed(dest, shown, point);
+        }
+
+        return (detail::FixedLength(shown, point) <= detail::ScientificLength(shown, point))
+            ? detail::WriteFixed(dest, shown, point) : detail::WriteScientific(dest, shown, point);
+    }
+
+    /*
+     * FormatDecimal of value, from its DecimalTable for 16 bit formats, and
+     * with FormatQuadDecimal for binary128 unless long double is binary128.
+     */
+    template<typename T>
+    inline char *FormatDecimal(char *dest, const IEEE754Float<T> &value, bool roundTrip,
+                               unsigned precision)
+    {
+        if constexpr(IEEE754Float<T>::numBits == 16)
+        {
+            if(DecimalTable<T> *table = DecimalTable<T>::Get(roundTrip, precision))
+            {
+                return table->Format(dest, static_cast<std::uint16_t>(value.GetBits()));
+            }
+        }
+        else if constexpr(std::is_same_v<T, Quad> && (LDBL_MANT_DIG != 113))
+        {
+            const FloatClass floatClass = value.GetFloatClass();
+
+            if((floatClass == FloatClass::Normal) || (floatClass == FloatClass::Subnormal))
+            {
+                return FormatQuadDecimal(dest, value, roundTrip, precision);
+            }
+        }
+
+        return FormatDecimal(dest, value.GetIEEEFloat(), roundTrip, precision);
+    }
+
+    /*
+     * Writes the low numDigits hex digits of bits to dest, most significant
+     * first, and returns the end of what was written.
+     */
+    inline char *FormatHex(char *dest, Bits bits, unsigned numDigits)
+    {
+        constexpr char digits[] = "0123456789ABCDEF";
+
+        for(unsigned i = 0; i < numDigits; i++)
+        {
+            *dest++ = digits[(bits >> ((numDigits - 1 - i) * 4)) & 0xF];
+        }
+
+        return dest;
+    }
+
+    /*
+     * Reads a hex token (maybe starting with "0x") into bits and returns its
+     * type, or Type::Bad. Without a forced type, the number of digits
+     * decides: up to 8 is a float, 16 a double, 20 an x87 extended and 32 a
+     * binary128. A forced type takes any token with at most as many digits
+     * as it has.
+     */
+    inline Type ScanHex(const std::string_view str, Bits *bits = nullptr,
+                        Type forced = Type::Bad)
+    {
+        hex::ScanResult scan   = hex::Scan(str);
+        Type            result = Type::Bad;
+
+        if(bits)
+        {
+            *bits = (Bits(scan.high) << 64) | scan.value;
+        }
+
+        switch(scan.width)
+        {
+        case hex::Width::Float:
+            result = Type::Float;
+            break;
+
+        case hex::Width::Double:
+            result = Type::Double;
+            break;
+
+        case hex::Width::Extended:
+            result = Type::Extended;
+            break;
+
+        case hex::Width::Quad:
+            result = Type::Quad;
+            break;
+
+        default:
+            return Type::Bad;
+        }
+
+        if(forced != Type::Bad)
+        {
+            result = (scan.digits.size() <= HexDigitsOf(forced)) ? forced : Type::Bad;
+        }
+
+        return result;
+    }
+
+    /*
+     * Parses str as T, correctly rounded. std::from_chars does the work (no
+     * locale, no allocation); it leaves values out of T's range alone, so those
+     * few go through strtod, which rounds them to infinity or zero like
+     * from_chars would have.
+     */
+    template<typename T>
+    inline bool ParseDecimalAs(const std::string_view str, Bits *bits)
+    {
+        const char *end   = str.data() + str.size();
+        T           value = 0;
+        auto [ptr, ec]    = std::from_chars(str.data(), end, value);
+
+        if(ptr != end)
+        {
+            return false;
+        }
+        else if(ec == std::errc::result_out_of_range)
+        {
+            std::string copy(str);
+
+            if constexpr(std::is_same_v<T, float>)
+            {
+                value = std::strtof(copy.c_str(), nullptr);
+            }
+            else if constexpr(std::is_same_v<T, double>)
+            {
+                value = std::strtod(copy.c_str(), nullptr);
+            }
+            else
+            {
+                value = std::strtold(copy.c_str(), nullptr);
+            }
+        }
+        else if(ec != std::errc())
+        {
+            return false;
+        }
+
+        if(bits)
+        {
+            // only the format's bytes, x87 long double has padding.
+            constexpr std::size_t valueBytes = (std::is_same_v<T, long double>
+                                                && (LDBL_MANT_DIG == 64)) ? 10 : sizeof(T);
+
+            *bits = 0;
+            std::memcpy(bits, &value, valueBytes);
+        }
+
+        return true;
+    }
+
+    /*
+     * Reads a decimal number (including inf and nan, with an optional sign)
+     * as the nearest value of type, double if it is Type::Bad, into bits.
+     * Returns the type, or Type::Bad if str is not a number or type has no
+     * correctly rounded parser (half, bfloat16, and binary128 unless long
+     * double is binary128).
+     */
+    inline Type ParseDecimal(std::string_view str, Bits *bits = nullptr,
+                             Type type = Type::Bad)
+    {
+        // from_chars takes a minus sign only.
+        if((str.size() > 1) && (str[0] == '+') && (str[1] != '-'))
+        {
+            str.remove_prefix(1);
+        }
+
+        switch(type)
+        {
+        case Type::Float:
+            return ParseDecimalAs<float>(str, bits) ? Type::Float : Type::Bad;
+
+        case Type::Bad:
+        case Type::Double:
+            return ParseDecimalAs<double>(str, bits) ? Type::Double : Type::Bad;
+
+#if LDBL_MANT_DIG == 64
+        case Type::Extended:
+            return ParseDecimalAs<long double>(str, bits) ? Type::Extended : Type::Bad;
+#elif LDBL_MANT_DIG == 113
+        case Type::Quad:
+            return ParseDecimalAs<long double>(str, bits) ? Type::Quad : Type::Bad;
+#endif
+
+        default:
+            return Type::Bad;
+        }
+    }
+
+    /*
+     * Class counts of some values, by sign (0 positive, 1 negative) and class.
+     */
+    using ClassCounts = std::uint64_t[2][numFloatClasses];
+
+    namespace detail
+    {
+        /*
+         * Sorts count raw UInt values at data, byte swapped if swap, into
+         * classes, and writes each value's top bits (sign and exponent) to tops.
+         */
+        template<typename T, typename UInt>
+        inline void ClassifyRawScalar(const char *data, std::size_t count, bool swap,
+                                      std::uint32_t *tops, ClassCounts &classes)
+        {
+            IEEE754Float<T> value;
+
+            for(std::size_t i = 0; i < count; i++)
+            {
+                UInt raw;
+
+                std::memcpy(&raw, data + (i * sizeof(UInt)), sizeof(raw));
+                if(swap)
+                {
+                    if constexpr(sizeof(UInt) == sizeof(std::uint64_t))
+                    {
+                        raw = __builtin_bswap64(raw);
+                    }
+                    else
+                    {
+                        raw = __builtin_bswap32(raw);
+                    }
+                }
+
+                value   = raw;
+                tops[i] = raw >> IEEE754Float<T>::mantissaBits;
+                classes[value.GetSignBit()][static_cast<unsigned>(value.GetFloatClass())]++;
+            }
+        }
+
+#ifdef HEX_HAS_X86
+        /* All ones in each UInt lane where a and b are equal. */
+        template<typename UInt>
+        __attribute__((target("avx2")))
+        inline __m256i LanesEqual(__m256i a, __m256i b)
+        {
+            if constexpr(sizeof(UInt) == sizeof(std::uint64_t))
+            {
+                return _mm256_cmpeq_epi64(a, b);
+            }
+            else
+            {
+                return _mm256_cmpeq_epi32(a, b);
+            }
+        }
+
+        /* All ones in each UInt lane of v that is negative. */
+        template<typename UInt>
+        __attribute__((target("avx2")))
+        inline __m256i LanesNegative(__m256i v)
+        {
+            if constexpr(sizeof(UInt) == sizeof(std::uint64_t))
+            {
+                return _mm256_cmpgt_epi64(_mm256_setzero_si256(), v);
+            }
+            else
+            {
+                return _mm256_srai_epi32(v, 31);
+            }
+        }
+
+        /* Counts the lanes of found, all ones where true, in positives or
+           negatives by the sign of the lane in negative. */
+        __attribute__((target("avx2")))
+        inline void CountLanes(__m256i found, __m256i negative,
+                               __m256i &positives, __m256i &negatives)
+        {
+            positives = _mm256_sub_epi32(positives, _mm256_andnot_si256(negative, found));
+            negatives = _mm256_sub_epi32(negatives, _mm256_and_si256(negative, found));
+        }
+
+        /* The sum of the 32 bit lanes of v. */
+        __attribute__((target("avx2")))
+        inline std::uint64_t LaneSum(__m256i v)
+        {
+            std::uint32_t lanes[8];
+            std::uint64_t sum = 0;
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), v);
+            for(std::uint32_t lane : lanes)
+            {
+                sum += lane;
+            }
+
+            return sum;
+        }
+
+        /*
+         * ClassifyRawScalar, a vector of values at a time. Each value's exponent
+         * and magnitude are compared with zero and all ones, and the compares
+         * (all ones, -1, where true) are subtracted from 32 bit lane counters, so
+         * the loop does not leave the registers. A double's compare counts in
+         * both of its 32 bit halves. The classes follow from the counters at the
+         * end.
+         */
+        template<typename T, typename UInt>
+        __attribute__((target("avx2")))
+        inline void ClassifyRawAVX2(const char *data, std::size_t count, bool swap,
+                                    std::uint32_t *tops, ClassCounts &classes)
+        {
+            constexpr bool     isDouble  = (sizeof(UInt) == sizeof(std::uint64_t));
+            constexpr unsigned lanes     = sizeof(__m256i) / sizeof(UInt);
+            constexpr UInt     signBit   = UInt(1) << (sizeof(UInt) * 8 - 1);
+            constexpr UInt     expBits   = (signBit - 1)
+                & ~((UInt(1) << IEEE754Float<T>::mantissaBits) - 1);
+            const __m256i      expMask   = isDouble ? _mm256_set1_epi64x(expBits)
+                : _mm256_set1_epi32(expBits);
+            const __m256i      absMask   = isDouble ? _mm256_set1_epi64x(signBit - 1)
+                : _mm256_set1_epi32(signBit - 1);
+            const __m256i      zero      = _mm256_setzero_si256();
+            const __m256i      bswapMask = isDouble
+                ? _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                   7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8)
+                : _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                   3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+            // what is counted, per sign, the classes follow from these.
+            enum { isZero, expZero, isInf, expMax, numCounters };
+
+            __m256i     counters[2][numCounters];
+            __m256i     negatives = zero;
+            std::size_t i         = 0;
+
+            for(auto &bySign : counters)
+            {
+                for(__m256i &counter : bySign)
+                {
+                    counter = zero;
+                }
+            }
+
+            for(; (i + lanes) <= count; i += lanes)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+                                                   data + (i * sizeof(UInt))));
+
+                if(swap)
+                {
+                    v = _mm256_shuffle_epi8(v, bswapMask);
+                }
+
+                if constexpr(isDouble)
+                {
+                    // the top 12 bits of each double, packed into the low half.
+                    __m256i top = _mm256_permutevar8x32_epi32(
+                        _mm256_srli_epi64(v, IEEE754Float<T>::mantissaBits),
+                        _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(tops + i),
+                                     _mm256_castsi256_si128(top));
+                }
+                else
+                {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(tops + i),
+                                        _mm256_srli_epi32(v, IEEE754Float<T>::mantissaBits));
+                }
+
+                __m256i exponent  = _mm256_and_si256(v, expMask);
+                __m256i magnitude = _mm256_and_si256(v, absMask);
+                __m256i negative  = LanesNegative<UInt>(v);
+
+                // spelled out, so the counters stay in registers.
+                negatives = _mm256_sub_epi32(negatives, negative);
+                CountLanes(LanesEqual<UInt>(magnitude, zero), negative,
+                           counters[0][isZero], counters[1][isZero]);
+                CountLanes(LanesEqual<UInt>(exponent, zero), negative,
+                           counters[0][expZero], counters[1][expZero]);
+                CountLanes(LanesEqual<UInt>(magnitude, expMask), negative,
+                           counters[0][isInf], counters[1][isInf]);
+                CountLanes(LanesEqual<UInt>(exponent, expMask), negative,
+                           counters[0][expMax], counters[1][expMax]);
+            }
+
+            if(i != 0)
+            {
+                constexpr unsigned halves = sizeof(UInt) / sizeof(std::uint32_t);
+
+                std::uint64_t numNegative  = LaneSum(negatives) / halves;
+                std::uint64_t numBySign[2] = { i - numNegative, numNegative };
+
+                for(unsigned sign = 0; sign < 2; sign++)
+                {
+                    std::uint64_t found[numCounters];
+
+                    for(unsigned c = 0; c < numCounters; c++)
+                    {
+                        found[c] = LaneSum(counters[sign][c]) / halves;
+                    }
+
+                    std::uint64_t *to = classes[sign];
+
+                    to[static_cast<unsigned>(FloatClass::Zero)]      += found[isZero];
+                    to[static_cast<unsigned>(FloatClass::Subnormal)] += found[expZero] - found[isZero];
+                    to[static_cast<unsigned>(FloatClass::Normal)]    += numBySign[sign]
+                        - found[expZero] - found[expMax];
+                    to[static_cast<unsigned>(FloatClass::Infinity)]  += found[isInf];
+                    to[static_cast<unsigned>(FloatClass::NaN)]       += found[expMax] - found[isInf];
+                }
+            }
+
+            ClassifyRawScalar<T, UInt>(data + (i * sizeof(UInt)), count - i, swap,
+                                       tops + i, classes);
+        }
+#endif
+    }
+
+    /*
+     * Sorts count raw UInt values of type T at data, byte swapped if swap,
+     * into classes (adding to what is there), and writes each value's top
+     * bits (sign and exponent) to tops. Uses AVX2 where the CPU has it.
+     */
+    template<typename T, typename UInt>
+    inline void ClassifyRaw(const char *data, std::size_t count, bool swap,
+                            std::uint32_t *tops, ClassCounts &classes)
+    {
+#ifdef HEX_HAS_X86
+        static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+
+        if(hasAVX2)
+        {
+            detail::ClassifyRawAVX2<T, UInt>(data, count, swap, tops, classes);
+            return;
+        }
+#endif
+        detail::ClassifyRawScalar<T, UInt>(data, count, swap, tops, classes);
+    }
+
+    /*
+     * Batch functions, for converting many values in one call. Inputs are a
+     * pointer and a count (C++17 has no std::span), outputs go to buffers of
+     * the caller's, nothing is allocated.
+     */
+
+    /*
+     * ScanHex for count tokens, into types and bits. Returns the number of
+     * tokens that were values.
+     */
+    inline std::size_t ScanHex(const std::string_view *tokens, std::size_t count,
+                               Type *types, Bits *bits, Type forced = Type::Bad)
+    {
+        std::size_t numValues = 0;
+
+        for(std::size_t i = 0; i < count; i++)
+        {
+            types[i]   = ScanHex(tokens[i], bits + i, forced);
+            numValues += (types[i] != Type::Bad);
+        }
+
+        return numValues;
+    }
+
+    /*
+     * ParseDecimal for count tokens, into types and bits. Returns the number
+     * of tokens that were numbers.
+     */
+    inline std::size_t ParseDecimal(const std::string_view *tokens, std::size_t count,
+                                    Type *types, Bits *bits, Type type = Type::Bad)
+    {
+        std::size_t numValues = 0;
+
+        for(std::size_t i = 0; i < count; i++)
+        {
+            bits[i]    = 0;
+            types[i]   = ParseDecimal(tokens[i], bits + i, type);
+            numValues += (types[i] != Type::Bad);
+        }
+
+        return numValues;
+    }
+
+    /*
+     * The classes of count values of T.
+     */
+    template<typename T>
+    inline void Classify(const Bits *bits, std::size_t count, FloatClass *classes)
+    {
+        IEEE754Float<T> value;
+
+        for(std::size_t i = 0; i < count; i++)
+        {
+            value      = bits[i];
+            classes[i] = value.GetFloatClass();
+        }
+    }
+
+    /*
+     * Writes the decimal values of count values of T to dest, which has room
+     * for size chars, one after the other with nothing in between; ends[i]
+     * is set to where value i ends. See FormatDecimal for roundTrip and
+     * precision. Each value needs room for precision + decimalExtraChars
+     * chars; stops at the first that might not fit. Returns the number of
+     * values written.
+     */
+    template<typename T>
+    inline std::size_t FormatDecimals(const Bits *bits, std::size_t count, bool roundTrip,
+                                      unsigned precision, char *dest, std::size_t size,
+                                      std::size_t *ends)
+    {
+        const std::size_t maxChars = precision + decimalExtraChars;
+        char             *cur      = dest;
+        std::size_t       i        = 0;
+        IEEE754Float<T>   value;
+
+        for(; (i < count) && ((size - (cur - dest)) >= maxChars); i++)
+        {
+            value   = bits[i];
+            cur     = FormatDecimal(cur, value, roundTrip, precision);
+            ends[i] = cur - dest;
+        }
+
+        return i;
+    }
+}
+
+#endif // IEEE754_HPP
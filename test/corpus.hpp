@@ -0,0 +1,166 @@
+/*
+ * Deterministic synthetic input for float: whitespace separated hex tokens
+ * with a chosen mix of values. The same kind, count and seed always give the
+ * same bytes, on any machine (std::mt19937_64's output is fixed by the
+ * standard, and no std distributions are used), so runs can be compared
+ * across releases.
+ */
+
+#ifndef CORPUS_HPP
+#define CORPUS_HPP
+
+#include <cstdint>     // uint64_t
+#include <cstddef>     // size_t
+#include <random>      // mt19937_64
+#include <string>      // string
+
+namespace corpus
+{
+    enum class Kind
+    {
+        Uniform,   // uniformly random bits, half floats, half doubles
+        NaNHeavy,  // 90% NaNs and infinities
+        Subnormal, // 90% subnormals and zeros
+        Mixed,     // 8, 16, 20 and 32 digits, "0x" and lowercase sometimes
+        Invalid,   // a quarter of the tokens are not hex floats
+    };
+
+    constexpr Kind kinds[] =
+    {
+        Kind::Uniform, Kind::NaNHeavy, Kind::Subnormal, Kind::Mixed, Kind::Invalid,
+    };
+
+    inline const char *Name(Kind kind)
+    {
+        switch(kind)
+        {
+        case Kind::Uniform:   return "uniform";
+        case Kind::NaNHeavy:  return "nan";
+        case Kind::Subnormal: return "subnormal";
+        case Kind::Mixed:     return "mixed";
+        case Kind::Invalid:   return "invalid";
+        }
+
+        return "";
+    }
+
+    namespace detail
+    {
+        /* Appends the low numDigits hex digits of bits. */
+        inline void AppendHex(std::string &out, std::uint64_t bits, unsigned numDigits,
+                              bool lower)
+        {
+            const char *digits = lower ? "0123456789abcdef" : "0123456789ABCDEF";
+
+            for(unsigned i = numDigits; i-- > 0;)
+            {
+                out.push_back(digits[(bits >> (i * 4)) & 0xF]);
+            }
+        }
+
+        /* Masks of the sign, exponent and fraction of a float or double. */
+        struct Fields
+        {
+            std::uint64_t sign;
+            std::uint64_t exponent;
+            std::uint64_t fraction;
+        };
+
+        inline Fields FieldsOf(bool isDouble)
+        {
+            return isDouble ? Fields{ 0x8000000000000000, 0x7FF0000000000000, 0x000FFFFFFFFFFFFF }
+                : Fields{ 0x80000000, 0x7F800000, 0x007FFFFF };
+        }
+
+        /* Bits of a NaN, or a quarter of the time an infinity. Bits 53 and
+           up are not part of a float's bits, or are a double's exponent. */
+        inline std::uint64_t Special(std::uint64_t random, bool isDouble)
+        {
+            const Fields fields   = FieldsOf(isDouble);
+            const bool   infinity = ((random >> 53) & 3) == 0;
+
+            return (random & (fields.sign | (infinity ? 0 : fields.fraction))) | fields.exponent;
+        }
+
+        /* Bits of a subnormal, or an eighth of the time a zero. */
+        inline std::uint64_t Tiny(std::uint64_t random, bool isDouble)
+        {
+            const Fields fields = FieldsOf(isDouble);
+            const bool   zero   = ((random >> 56) & 7) == 0;
+
+            return random & (fields.sign | (zero ? 0 : fields.fraction));
+        }
+    }
+
+    /*
+     * Returns count tokens of kind, one per line, from seed.
+     */
+    inline std::string Make(Kind kind, std::size_t count, std::uint64_t seed = 1)
+    {
+        std::mt19937_64 random(seed);
+        std::string     out;
+
+        out.reserve(count * 18);
+        for(std::size_t i = 0; i < count; i++)
+        {
+            std::uint64_t bits     = random();
+            std::uint64_t choice   = random();
+            bool          isDouble = choice & 1;
+            unsigned      digits   = isDouble ? 16 : 8;
+            bool          lower    = false;
+
+            switch(kind)
+            {
+            case Kind::Uniform:
+                break;
+
+            case Kind::NaNHeavy:
+                if(((choice >> 8) % 10) != 0)
+                {
+                    bits = detail::Special(bits, isDouble);
+                }
+                break;
+
+            case Kind::Subnormal:
+                if(((choice >> 8) % 10) != 0)
+                {
+                    bits = detail::Tiny(bits, isDouble);
+                }
+                break;
+
+            case Kind::Mixed:
+                digits = (choice >> 1) % 4;
+                digits = (digits == 0) ? 8 : (digits == 1) ? 16 : (digits == 2) ? 20 : 32;
+                lower  = (choice >> 3) & 1;
+                if((choice >> 4) & 1)
+                {
+                    out.append("0x");
+                }
+                break;
+
+            case Kind::Invalid:
+                if(((choice >> 1) % 4) == 0)
+                {
+                    // hex with a bad digit, or too many digits.
+                    out.append(((choice >> 3) & 1) ? "DEADBEEG"
+                               : "123456789ABCDEF0123456789ABCDEF01");
+                    out.push_back('\n');
+                    continue;
+                }
+                break;
+            }
+
+            if(digits > 16)
+            {
+                detail::AppendHex(out, random(), digits - 16, lower);
+                digits = 16;
+            }
+            detail::AppendHex(out, bits, digits, lower);
+            out.push_back('\n');
+        }
+
+        return out;
+    }
+}
+
+#endif // CORPUS_HPP
@@ -0,0 +1,360 @@
+/*
+ * Google Benchmark timings of each stage of float, on the corpora of
+ * corpus.hpp. float.cpp is built in with its main left out.
+ *
+ *     g++ -std=c++17 -O2 -pthread test/float-bench.cpp -lbenchmark -o float-bench
+ */
+
+#include <benchmark/benchmark.h>
+
+#define FLOAT_NO_MAIN
+#include "../float.cpp"
+
+#include "corpus.hpp"
+
+namespace
+{
+    constexpr std::size_t corpusSize = 1 << 16; // tokens per corpus
+
+    /* The corpus of a benchmark's first argument, made once. */
+    static const std::string &CorpusOf(const benchmark::State &state)
+    {
+        static std::string corpora[std::size(corpus::kinds)];
+        std::string       &text = corpora[state.range(0)];
+
+        if(text.empty())
+        {
+            text = corpus::Make(corpus::kinds[state.range(0)], corpusSize);
+        }
+
+        return text;
+    }
+
+    /* The tokens of a corpus. */
+    static std::vector<std::string_view> TokensOf(const std::string &text)
+    {
+        std::vector<std::string_view> tokens;
+        ::Tokenizer                   tokenizer(text);
+        std::string_view              token;
+
+        while(tokenizer.Next(token))
+        {
+            tokens.push_back(token);
+        }
+
+        return tokens;
+    }
+
+    /* The bits of the valid tokens of a corpus, of T's size. */
+    template<typename T>
+    static std::vector<::Bits> BitsOf(const benchmark::State &state)
+    {
+        constexpr unsigned  numBits = ::IEEE754Float<T>::numBits;
+        // ~0 for binary128, which a shift by 128 would not give.
+        constexpr ::Bits    mask    = (numBits < 128) ? ((::Bits(1) << (numBits % 128)) - 1)
+            : ~::Bits(0);
+        std::vector<::Bits> values;
+
+        for(std::string_view token : ::TokensOf(::CorpusOf(state)))
+        {
+            ::Bits bits;
+
+            if(::IsFloatOrDouble(token, &bits) != ::Input::BadInput)
+            {
+                values.push_back(bits & mask);
+            }
+        }
+
+        return values;
+    }
+
+    /* Names the benchmark's runs after the corpora. */
+    static void Corpora(benchmark::internal::Benchmark *benchmark)
+    {
+        for(std::size_t i = 0; i < std::size(corpus::kinds); i++)
+        {
+            benchmark->Arg(i);
+        }
+        benchmark->ArgName("corpus");
+    }
+
+    static void BM_Tokenize(benchmark::State &state)
+    {
+        const std::string &text = ::CorpusOf(state);
+
+        for(auto _ : state)
+        {
+            ::Tokenizer      tokenizer(text);
+            std::string_view token;
+            std::size_t      count = 0;
+
+            while(tokenizer.Next(token))
+            {
+                count++;
+            }
+            benchmark::DoNotOptimize(count);
+        }
+
+        state.SetBytesProcessed(state.iterations() * text.size());
+        state.SetItemsProcessed(state.iterations() * corpusSize);
+    }
+    BENCHMARK(BM_Tokenize)->Apply(::Corpora);
+
+    static void BM_IsFloatOrDouble(benchmark::State &state)
+    {
+        const std::vector<std::string_view> tokens = ::TokensOf(::CorpusOf(state));
+
+        for(auto _ : state)
+        {
+            for(std::string_view token : tokens)
+            {
+                ::Bits bits;
+
+                benchmark::DoNotOptimize(::IsFloatOrDouble(token, &bits));
+                benchmark::DoNotOptimize(bits);
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * tokens.size());
+    }
+    BENCHMARK(BM_IsFloatOrDouble)->Apply(::Corpora);
+
+    template<typename T>
+    static void BM_HexStrToIEEEFloat(benchmark::State &state)
+    {
+        std::vector<std::string_view> tokens;
+
+        for(std::string_view token : ::TokensOf(::CorpusOf(state)))
+        {
+            if(hex::StripPrefix(token).size() == (::IEEE754Float<T>::numBits / 4))
+            {
+                tokens.push_back(hex::StripPrefix(token));
+            }
+        }
+
+        for(auto _ : state)
+        {
+            for(std::string_view token : tokens)
+            {
+                benchmark::DoNotOptimize(::IEEE754Float<T>::HexStrToIEEEFloat(token));
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * tokens.size());
+    }
+    BENCHMARK_TEMPLATE(BM_HexStrToIEEEFloat, float)->Arg(0)->Arg(3)->ArgName("corpus");
+    BENCHMARK_TEMPLATE(BM_HexStrToIEEEFloat, double)->Arg(0)->Arg(3)->ArgName("corpus");
+
+    template<typename T>
+    static void BM_GetBinary(benchmark::State &state)
+    {
+        const std::vector<::Bits> values = ::BitsOf<T>(state);
+        char                      bin[::IEEE754Float<T>::numBits];
+
+        for(auto _ : state)
+        {
+            for(::Bits bits : values)
+            {
+                ::IEEE754Float<T> value;
+
+                value = bits;
+                value.GetBinary(bin);
+                benchmark::DoNotOptimize(bin);
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * values.size());
+    }
+    BENCHMARK_TEMPLATE(BM_GetBinary, float)->Arg(0)->ArgName("corpus");
+    BENCHMARK_TEMPLATE(BM_GetBinary, double)->Arg(0)->ArgName("corpus");
+
+    template<typename T>
+    static void BM_PrintFormattedOutput(benchmark::State &state)
+    {
+        const std::vector<::Bits> values = ::BitsOf<T>(state);
+        ::OutputBuffer            out;
+
+        for(auto _ : state)
+        {
+            for(::Bits bits : values)
+            {
+                ::IEEE754Float<T> value;
+
+                value = bits;
+                value.PrintFormattedOutput(out);
+            }
+            out.Clear();
+        }
+
+        state.SetItemsProcessed(state.iterations() * values.size());
+    }
+    BENCHMARK_TEMPLATE(BM_PrintFormattedOutput, float)->Apply(::Corpora);
+    BENCHMARK_TEMPLATE(BM_PrintFormattedOutput, double)->Apply(::Corpora);
+
+    /* The second argument is the precision, or -1 for -r. */
+    template<typename T>
+    static void BM_FormatDecimal(benchmark::State &state)
+    {
+        const std::vector<::Bits> values    = ::BitsOf<T>(state);
+        const bool                roundTrip = (state.range(1) < 0);
+        const unsigned            precision = roundTrip ? 0 : state.range(1);
+        std::string               dest(precision + ::decimalExtraChars, '\0');
+
+        for(auto _ : state)
+        {
+            for(::Bits bits : values)
+            {
+                ::IEEE754Float<T> value;
+
+                value = bits;
+                benchmark::DoNotOptimize(::FormatDecimal(dest.data(), value, roundTrip,
+                                                         precision));
+            }
+        }
+
+        state.SetItemsProcessed(state.iterations() * values.size());
+    }
+    BENCHMARK_TEMPLATE(BM_FormatDecimal, float)
+        ->ArgsProduct({ { 0, 1, 2 }, { 2, 9, -1 } })->ArgNames({ "corpus", "precision" });
+    BENCHMARK_TEMPLATE(BM_FormatDecimal, double)
+        ->ArgsProduct({ { 0, 1, 2 }, { 2, 17, -1 } })->ArgNames({ "corpus", "precision" });
+    // from the decimal tables, once they are filled
+    BENCHMARK_TEMPLATE(BM_FormatDecimal, ::Half)
+        ->ArgsProduct({ { 0 }, { 2, -1 } })->ArgNames({ "corpus", "precision" });
+    // the mixed corpus has 32 digit tokens, the others are subnormal.
+    BENCHMARK_TEMPLATE(BM_FormatDecimal, ::Quad)
+        ->ArgsProduct({ { 3 }, { 2, 36, -1 } })->ArgNames({ "corpus", "precision" });
+
+    /* The whole text pipeline on a corpus: tokenizing, parsing and printing
+       tables, into memory. The second argument is 1 for -s, the third 1 for
+       --stats. */
+    static void BM_EndToEnd(benchmark::State &state)
+    {
+        const std::string &text = ::CorpusOf(state);
+        ::OutputBuffer     out;
+        ::OutputBuffer     err;
+        ::ErrorLog         errors(err, ::Settings().maxErrors);
+
+        for(auto _ : state)
+        {
+            ::Settings settings;
+
+            settings.simpleOutput = (state.range(1) != 0);
+            settings.stats        = (state.range(2) != 0);
+            errors.StartBlock(text, ::Position());
+            benchmark::DoNotOptimize(::ConvertTextBlock(settings, text, out, errors));
+            out.Clear();
+            err.Clear();
+        }
+
+        state.SetBytesProcessed(state.iterations() * text.size());
+        state.SetItemsProcessed(state.iterations() * corpusSize);
+    }
+    BENCHMARK(BM_EndToEnd)
+        ->ArgsProduct({ { 0, 1, 2, 3, 4 }, { 0, 1 }, { 0, 1 } })
+        ->ArgNames({ "corpus", "simple", "stats" });
+
+    /* --sweep of the first argument's floats from 1.0 up, simple output,
+       into memory. */
+    static void BM_Sweep(benchmark::State &state)
+    {
+        ::Settings     settings;
+        ::OutputBuffer out;
+        ::OutputBuffer err;
+        ieee754::Type  type;
+        ::Bits         first;
+        ::Bits         last;
+
+        settings.simpleOutput = true;
+        settings.sweepFirst   = "3F800000";
+        settings.sweepLast    = "3F800000";
+        ::GetSweepRange(settings, type, first, last, err);
+        last = first + state.range(0) - 1;
+
+        for(auto _ : state)
+        {
+            benchmark::DoNotOptimize(::Sweep(settings, type, first, last, out));
+            out.Clear();
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+    BENCHMARK(BM_Sweep)->Arg(corpusSize);
+
+    /* The same as BM_EndToEnd, but from a memory mapped file, as float
+       reads its arguments, or with the third argument 1, read through
+       io_uring. */
+    static void BM_ConvertFile(benchmark::State &state)
+    {
+        const std::string &text    = ::CorpusOf(state);
+        char               path[]  = "/tmp/float-bench-XXXXXX";
+        int                fd      = ::mkstemp(path);
+        ::OutputBuffer     out;
+        ::OutputBuffer     err;
+        ::ErrorLog         errors(err, ::Settings().maxErrors);
+        bool               bad     = false;
+
+        if((fd < 0) || (::write(fd, text.data(), text.size())
+                        != static_cast<ssize_t>(text.size())))
+        {
+            state.SkipWithError("could not write the corpus file");
+            return;
+        }
+
+        for(auto _ : state)
+        {
+            ::currentSettings              = ::Settings();
+            ::currentSettings.simpleOutput = (state.range(1) != 0);
+            ::currentSettings.io           = (state.range(2) != 0) ? ::IoBackend::Uring
+                : ::IoBackend::Auto;
+            benchmark::DoNotOptimize(::ConvertPath(path, out, errors, bad));
+            out.Clear();
+            err.Clear();
+        }
+
+        ::close(fd);
+        ::unlink(path);
+        state.SetBytesProcessed(state.iterations() * text.size());
+        state.SetItemsProcessed(state.iterations() * corpusSize);
+    }
+    BENCHMARK(BM_ConvertFile)
+        ->Args({ 0, 1, 0 })->Args({ 3, 1, 0 })->Args({ 0, 1, 1 })
+        ->ArgNames({ "corpus", "simple", "uring" });
+
+    /* --diff of a corpus file against itself: parsing and comparing, with
+       nothing to print. */
+    static void BM_Diff(benchmark::State &state)
+    {
+        const std::string &text   = ::CorpusOf(state);
+        char               path[] = "/tmp/float-bench-XXXXXX";
+        int                fd     = ::mkstemp(path);
+        ::OutputBuffer     out;
+        bool               bad    = false;
+
+        if((fd < 0) || (::write(fd, text.data(), text.size())
+                        != static_cast<ssize_t>(text.size())))
+        {
+            state.SkipWithError("could not write the corpus file");
+            return;
+        }
+
+        for(auto _ : state)
+        {
+            int first  = ::open(path, O_RDONLY);
+            int second = ::open(path, O_RDONLY);
+
+            benchmark::DoNotOptimize(::Diff(::Settings(), first, second, out, bad));
+            ::close(first);
+            ::close(second);
+            out.Clear();
+        }
+
+        ::close(fd);
+        ::unlink(path);
+        state.SetBytesProcessed(state.iterations() * text.size() * 2);
+        state.SetItemsProcessed(state.iterations() * corpusSize);
+    }
+    BENCHMARK(BM_Diff)->Arg(0)->Arg(3)->ArgName("corpus");
+}
+
+BENCHMARK_MAIN();
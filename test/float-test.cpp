@@ -1,358 +1,1082 @@
 #include <gtest/gtest.h>
 
-#include <iostream>
-#include <iomanip>
 #include <string>
-#include <algorithm>
 #include <string_view>
-#include <cctype>
-#include <cstring>
+#include <cstdio>
+#include <random>
 
-namespace
-{
-    /*
-     * Help string.
-     */
-    const static std::string helpStr = R"HELP(Usage: float <flags>
-Takes in data as a hexadecimal value (from standard in) and outputs its 
-floating-point representation. 
-)HELP";
-
-    /*
-     * String describing the last error that .
-     */
-    
-    static std::string lastErrorMsg;
-    
-    /*
-     * The type of input that the user has used.
-     */
-    enum class Input
-    {
-        BadInput,
-        Exit,
+#define FLOAT_NO_MAIN
+#include "../float.cpp"
 
-        Float,
-        Double,
+TEST(InputTypeTest, quitType) {
+    ::Settings settings;
+    ::Input    input = ::GetInputType(settings, "Q");
+    ASSERT_EQ(::Input::Exit, input);
+}
 
-        Mode
-    };
+TEST(InputTypeTest, flagType) {
+    ::Settings settings;
+    ::Input    input = ::GetInputType(settings, "-s");
+    ASSERT_EQ(::Input::Flag, input);
+    EXPECT_TRUE(settings.simpleOutput);
+    EXPECT_EQ(::Input::BadInput, ::GetInputType(settings, "-A"));
+    ::lastError = ::Error::None;
+}
 
-    /*
-     * The current mode, or way to interpret input.
-     */
-    enum class Mode
-    {
-        Help,
-        
-    };
+TEST(InputTypeTest, precisionFlag) {
+    ::Settings settings;
 
-    /*
-     * Representation of an IEEE 754 float, 32 or 64 bit.
-     */
-    template<typename T>
-    class IEEE754Float
-    {
-    private:
-        // utilizes the union trick to convert from hex to float.
-        union
-        {
-            std::uint64_t _uint;  // 64_t to ensure it is as large as a double.
-            T             _float; // float type
-        };
+    EXPECT_EQ(::Input::Flag, ::GetInputType(settings, "-p5"));
+    EXPECT_EQ(5u, settings.precision);
+    EXPECT_EQ(::Input::BadInput, ::GetInputType(settings, "-p7abc"));
+    EXPECT_EQ(::Input::BadInput, ::GetInputType(settings, "-p"));
+    EXPECT_EQ(5u, settings.precision);
+    EXPECT_EQ(::Input::Flag, ::GetInputType(settings, "-p3000000000"));
+    EXPECT_EQ(ieee754::maxDecimalPrecision, settings.precision);
+    EXPECT_EQ(::Input::BadInput, ::GetInputType(settings, "-p99999999999"));
+    ::lastError = ::Error::None;
+}
 
-        static constexpr std::size_t maxSizeOfBinBuffer = (sizeof(_uint) * 8);
+TEST(InputTypeTest, ford) {
+    ::Input input = ::IsFloatOrDouble("DEAD");
+    EXPECT_EQ(::Input::Float, input);
+}
 
-        // string representing the _float's bits (1's or 0's).
-        using oCString = char[maxSizeOfBinBuffer + 1];
+TEST(IEEE754Test, batchParse) {
+    std::string_view tokens[] = { "3F800000", "0x400921FB54442D18", "zz", "DEAD" };
+    ieee754::Type    types[4];
+    ieee754::Bits    bits[4];
 
-        /* largely a wrapper around oCString type so it can be returned from
-           a function, as arrays cannot be returned in C, but structs can. */
+    EXPECT_EQ(3u, ieee754::ScanHex(tokens, 4, types, bits));
+    EXPECT_EQ(ieee754::Type::Float, types[0]);
+    EXPECT_EQ(ieee754::Type::Double, types[1]);
+    EXPECT_EQ(ieee754::Type::Bad, types[2]);
+    EXPECT_TRUE(bits[1] == 0x400921FB54442D18u);
 
-    public:
-        struct outputString
-        {
-            oCString str = { '\0' };  // string representation _uint (binary)
-            unsigned strSize = 0;     // how many bytes were actually used.
-            ::Input  inputType;
-            
-            char& operator[](unsigned index)
-            {
-                return str[index];
-            }
+    std::string_view decimals[] = { "1", "+inf", "-2.5", "1e" };
 
-            outputString operator=(outputString &ostr)
-            {
-                std::strncpy(this->str, ostr.str, ostr.strSize);
-                this->strSize = ostr.strSize;
-                this->inputType = ostr.inputType;
-            }
+    EXPECT_EQ(3u, ieee754::ParseDecimal(decimals, 4, types, bits, ieee754::Type::Float));
+    EXPECT_TRUE(bits[0] == 0x3F800000u);
+    EXPECT_TRUE(bits[1] == 0x7F800000u);
+    EXPECT_TRUE(bits[2] == 0xC0200000u);
+    EXPECT_EQ(ieee754::Type::Bad, types[3]);
+}
 
-            bool operator==(outputString ostr)
-                {
-                    if(strSize != ostr.strSize)
-                        return false;
-                    if(inputType != ostr.inputType)
-                        return false;
-                    for(int i = 0; i < strSize; i++)
-                    {
-                        if(this[i] != ostr[i])
-                        {
-                            return false;
-                        }
-                    }
+TEST(IEEE754Test, batchClassifyAndFormat) {
+    const ieee754::Bits  bits[] = { 0x3F800000, 0x80000000, 0x00000001, 0xFF800000, 0x7FC00000 };
+    ieee754::FloatClass  classes[5];
+    char                 text[5 * (2 + ieee754::decimalExtraChars)];
+    std::size_t          ends[5];
 
-                    return true;
-                }
-        };
-
-        outputString getBinary()
-        { 
-            char             *uintBuf;           /* char buffer
-                                                    representation of uint */
-            std::size_t       sizeofUintBuf = 0; // size of the buffer
-            outputString      binBuffer;         // return value
-
-            /* determine the size of uintBuf. this is necessary so doubles and
-               floats are not confused. */
-            switch(sizeof(_float))
-            {
-            case sizeof(double):
-                uintBuf = (char*) &_uint;
-                sizeofUintBuf = sizeof(double);
-                binBuffer.inputType = ::Input::Double;
-                break;
-
-            case sizeof(float):
-                std::uint32_t newUint = static_cast<std::uint32_t>(_uint);
-                uintBuf = (char*) &newUint;
-                sizeofUintBuf = sizeof(float);
-                binBuffer.inputType = ::Input::Float;
-                break;
-            }
+    ieee754::Classify<float>(bits, 5, classes);
+    EXPECT_EQ(ieee754::FloatClass::Normal, classes[0]);
+    EXPECT_EQ(ieee754::FloatClass::Zero, classes[1]);
+    EXPECT_EQ(ieee754::FloatClass::Subnormal, classes[2]);
+    EXPECT_EQ(ieee754::FloatClass::Infinity, classes[3]);
+    EXPECT_EQ(ieee754::FloatClass::NaN, classes[4]);
 
-            // loop through each byte of the uint
-            for(int j = sizeofUintBuf - 1; j >=  0; j--)
-            {
-                char curByte = uintBuf[j];
-                // get each bit from _uint bytes
-                for(int i = (sizeof(curByte) * 8) - 1; i >= 0; i--)
-                {
-                    char curChar;
+    ASSERT_EQ(5u, ieee754::FormatDecimals<float>(bits, 5, false, 2, text, sizeof(text), ends));
+    EXPECT_EQ("1", std::string(text, ends[0]));
+    EXPECT_EQ("-inf", std::string(text + ends[2], ends[3] - ends[2]));
 
-                    if(curByte & (1u << i))
-                    {
-                        curChar = '1';
-                    }
-                    else
-                    {
-                        curChar = '0';
-                    }
+    // no room for a value that might be long
+    EXPECT_EQ(0u, ieee754::FormatDecimals<float>(bits, 5, false, 2, text,
+                                                 1 + ieee754::decimalExtraChars, ends));
+}
 
-                    binBuffer[binBuffer.strSize++] = curChar;
-                }
-            }
-            
-            return binBuffer;
+TEST(IEEE754Test, decimalTableMatchesFormat) {
+    char expected[ieee754::decimalExtraChars + 24];
+    char text[ieee754::decimalExtraChars + 24];
+
+    // twice, so the second pass is copies from the tables.
+    for(int pass = 0; pass < 2; pass++)
+    {
+        for(unsigned bits = 0; bits < 0x10000; bits++)
+        {
+            const ieee754::IEEE754Float<ieee754::BFloat16> value(bits);
+            char *end = ieee754::FormatDecimal(expected, value.GetIEEEFloat(), true, 0);
+
+            ASSERT_EQ(std::string(expected, end),
+                      std::string(text, ieee754::FormatDecimal(text, value, true, 0)));
+            end = ieee754::FormatDecimal(expected, value.GetIEEEFloat(), false, 24);
+            ASSERT_EQ(std::string(expected, end),
+                      std::string(text, ieee754::FormatDecimal(text, value, false, 24)));
         }
+    }
+    EXPECT_EQ(nullptr, ieee754::DecimalTable<ieee754::Half>::Get(false, 25));
+}
+
+TEST(IEEE754Test, quadDecimal) {
+    char text[40 + ieee754::decimalExtraChars];
+
+    auto format = [&](ieee754::Bits bits, bool roundTrip, unsigned precision)
+                  {
+                      ieee754::IEEE754Float<ieee754::Quad> value;
 
-    public:
-        static IEEE754Float<T> HexStrToIEEEFloat(const std::string_view hex)
+                      value = bits;
+                      return std::string(text, ieee754::FormatDecimal(text, value, roundTrip,
+                                                                      precision));
+                  };
+    const ieee754::Bits third = (ieee754::Bits(0x3FFD555555555555) << 64) | 0x5555555555555555;
+    const ieee754::Bits max   = (ieee754::Bits(0x7FFEFFFFFFFFFFFF) << 64) | 0xFFFFFFFFFFFFFFFF;
+
+    EXPECT_EQ("1", format(ieee754::Bits(0x3FFF) << 112, true, 0));
+    EXPECT_EQ("-50", format(ieee754::Bits(0xC004900000000000) << 64, true, 0));
+    EXPECT_EQ("0.3333333333333333333333333333333333", format(third, true, 0));
+    EXPECT_EQ("0.33", format(third, false, 2));
+    // below long double's range, so these came out as 0 through it.
+    EXPECT_EQ("6e-4966", format(1, true, 0));
+    EXPECT_EQ("6.5e-4966", format(1, false, 2));
+    EXPECT_EQ("1.189731495357231765085759326628007e+4932", format(max, true, 0));
+    // precisions above 36 are cut to 36.
+    EXPECT_EQ("0.333333333333333333333333333333333317", format(third, false, 40));
+
+    // the fast path against the exact, slow one, at every size and in
+    // subnormals and powers of 2.
+    std::mt19937_64 rng(754);
+
+    for(int i = 0; i < 150; i++)
+    {
+        const ieee754::Bits bits = (i % 3 == 0) ? (ieee754::Bits(rng()) >> (rng() % 64))
+            : (i % 3 == 1) ? (ieee754::Bits(rng() & 0x7FFF000000000000) << 64)
+            : ((ieee754::Bits(rng()) << 64) | rng());
+        ieee754::IEEE754Float<ieee754::Quad> value;
+
+        value = bits;
+        if((bits == 0) || (value.GetExponentBits() == 0x7FFF))
         {
-            std::istringstream hexVal(hex.data());
-            std::uint64_t      inputAsHex;
-            IEEE754Float<T>    floatVal;
+            continue;
+        }
 
-            hexVal >> std::hex >> inputAsHex;
-            floatVal = inputAsHex;
+        const ieee754::Bits fraction    = value.GetMantissaBits();
+        const ieee754::Bits mantissa    = fraction
+            | ((value.GetExponentBits() != 0) ? (ieee754::Bits(1) << 112) : 0);
+        const int           exponent    = value.GetExponent() - 112;
+        const bool          closerBelow = (fraction == 0) && (value.GetExponentBits() > 1);
+
+        for(unsigned count : { 0, 1, 2, 17, 36 })
+        {
+            char              digits[40];
+            char              slowDigits[40];
+            int               point     = 0;
+            int               slowPoint = 0;
+            const std::size_t size      = ieee754::detail::QuadDigits(digits, point, mantissa,
+                                                                      exponent, closerBelow,
+                                                                      count, false);
+            const std::size_t slowSize  = ieee754::detail::QuadDigits(slowDigits, slowPoint,
+                                                                      mantissa, exponent,
+                                                                      closerBelow, count, true);
 
-            return floatVal;
+            ASSERT_NE(0u, slowSize) << i << " " << count;
+            if(size != 0)
+            {
+                ASSERT_EQ(std::string(slowDigits, slowSize), std::string(digits, size))
+                    << i << " " << count;
+                ASSERT_EQ(slowPoint, point) << i << " " << count;
+            }
         }
+    }
+}
 
-        
-        IEEE754Float() = default;
-        
-        IEEE754Float(unsigned i)
-            : _uint(i)
+/*
+ * count raw UInt values of T, of every class and both signs, in the byte
+ * order swap says.
+ */
+template<typename T, typename UInt>
+static std::string RawValues(std::mt19937_64 &rng, std::size_t count, bool swap)
+{
+    constexpr unsigned mantissaBits = ieee754::IEEE754Float<T>::mantissaBits;
+    constexpr UInt     signBit      = UInt(1) << (sizeof(UInt) * 8 - 1);
+    constexpr UInt     mantissaMask = (UInt(1) << mantissaBits) - 1;
+    constexpr UInt     expMask      = (signBit - 1) & ~mantissaMask;
+    std::string        data(count * sizeof(UInt), '\0');
+
+    for(std::size_t i = 0; i < count; i++)
+    {
+        const UInt sign     = (rng() & 1) ? signBit : 0;
+        const UInt mantissa = static_cast<UInt>(rng()) & mantissaMask;
+        UInt       raw      = 0;
+
+        switch(rng() % 6)
         {
+        case 0: raw = static_cast<UInt>(rng()); break;
+        case 1: raw = sign; break;
+        case 2: raw = sign | mantissa | 1; break;
+        case 3: raw = sign | expMask; break;
+        case 4: raw = sign | expMask | mantissa | 1; break;
+        default: raw = sign | (static_cast<UInt>(rng()) & expMask) | mantissa; break;
         }
 
-        IEEE754Float<T> operator=(std::uint64_t i)
+        if(swap)
         {
-            _uint = i;
-            return *this;
+            if constexpr(sizeof(UInt) == sizeof(std::uint64_t))
+            {
+                raw = __builtin_bswap64(raw);
+            }
+            else
+            {
+                raw = __builtin_bswap32(raw);
+            }
         }
+        std::memcpy(&data[i * sizeof(UInt)], &raw, sizeof(raw));
+    }
+
+    return data;
+}
 
-        void PrintFormattedOutput()
+template<typename T, typename UInt>
+static void CheckClassifyRaw(std::mt19937_64 &rng)
+{
+    // around the vector width and the summary's batches of 1024.
+    for(std::size_t count : { 1, 3, 5, 7, 9, 33, 1023, 1025, 2053 })
+    {
+        for(bool swap : { false, true })
         {
-            outputString      os = getBinary();
-            unsigned          exponentSize;
-            unsigned          tableSize;
+            const std::string          data = RawValues<T, UInt>(rng, count, swap);
+            std::vector<std::uint32_t> tops(count);
+            std::vector<std::uint32_t> scalarTops(count);
+            ieee754::ClassCounts       classes = {};
+            ieee754::ClassCounts       scalarClasses = {};
 
-            switch(os.inputType)
+            SCOPED_TRACE(testing::Message() << sizeof(UInt) << " bytes, " << count
+                         << " values, swap " << swap);
+
+            ieee754::detail::ClassifyRawScalar<T, UInt>(data.data(), count, swap,
+                                                        scalarTops.data(), scalarClasses);
+            if(__builtin_cpu_supports("avx2"))
             {
-            case ::Input::Float:
-                exponentSize = 8;
-                tableSize = 45;
-                break;
-
-            case ::Input::Double:
-                exponentSize = 11;
-                tableSize = 77;
-                break;
-
-            default:
-                return; // TODO something has gone horribly wrong...
-                break;
+                ieee754::detail::ClassifyRawAVX2<T, UInt>(data.data(), count, swap,
+                                                          tops.data(), classes);
+                EXPECT_EQ(scalarTops, tops);
+                for(unsigned sign = 0; sign < 2; sign++)
+                {
+                    for(unsigned c = 0; c < ieee754::numFloatClasses; c++)
+                    {
+                        EXPECT_EQ(scalarClasses[sign][c], classes[sign][c]);
+                    }
+                }
             }
-            
-            // prints the top and bottom of the table
-            auto printEnds = [&]()
-                                 {
-                                     std::cout << std::setw(tableSize)
-                                               << std::setfill('=')
-                                               << '\n';
-                                 };
-
-            char columnStr[] = "||";
-            char signStr[] = " Sign";
-            char expStr[] = "Exponent";
-
-            printEnds();
-            
-            std::cout << columnStr << signStr << columnStr << std::setfill(' ')  << std::setw(exponentSize) << expStr << columnStr
-                      << std::setw(os.strSize - (exponentSize + 1)) << "Mantissa" << columnStr
-                      << std::endl;
-            
-            std::cout << columnStr << std::setfill(' ')
-                      << std::setw((sizeof(signStr) - 1) + (sizeof(columnStr) - 1) - sizeof(columnStr) + 1)
-                      << os[0] << columnStr << std::flush;
-
-            // print the string's exponent [1, exponentsize]
-            for(unsigned i = 1; i <= exponentSize; i++)
+
+            // one value at a time, in one pass, and in three merged chunks.
+            ::Summary      single;
+            ::Summary      whole;
+            ::Summary      merged;
+            ::OutputBuffer expected;
+            ::OutputBuffer out;
+
+            for(std::size_t i = 0; i < count; i++)
             {
-                std::cout << os[i];
+                UInt raw;
+
+                std::memcpy(&raw, data.data() + (i * sizeof(UInt)), sizeof(raw));
+                if(swap)
+                {
+                    raw = (sizeof(UInt) == sizeof(std::uint64_t))
+                        ? static_cast<UInt>(__builtin_bswap64(raw))
+                        : static_cast<UInt>(__builtin_bswap32(static_cast<std::uint32_t>(raw)));
+                }
+                single.Add<T>(raw);
             }
+            whole.AddRaw<T, UInt>(data.data(), count, swap);
 
-            std::cout << columnStr;
-            // print the mantissa (fraction) (exponentsize, end]
-            for(unsigned i = exponentSize + 1; i < os.strSize; i++)
+            const std::size_t cuts[] = { 0, count / 3, count - (count / 4), count };
+
+            for(int part = 0; part < 3; part++)
             {
-                std::cout << os[i];
+                ::Summary chunk;
+
+                chunk.AddRaw<T, UInt>(data.data() + (cuts[part] * sizeof(UInt)),
+                                      cuts[part + 1] - cuts[part], swap);
+                merged.Merge(chunk);
             }
 
-            std::cout << columnStr << std::endl;
-            printEnds();
+            single.Print(expected);
+            whole.Print(out);
+            EXPECT_EQ(expected.View(), out.View());
+            out.Clear();
+            merged.Print(out);
+            EXPECT_EQ(expected.View(), out.View());
         }
+    }
+}
+
+TEST(SummaryTest, rawClassesAndExponents) {
+    std::mt19937_64 rng(754);
+
+    CheckClassifyRaw<float, std::uint32_t>(rng);
+    CheckClassifyRaw<double, std::uint64_t>(rng);
+}
+
+TEST(SessionTest, splitTokens) {
+    ::Settings settings;
+
+    settings.simpleOutput = true;
+
+    ::Session session(settings);
+
+    session.Receive("3F80");
+    EXPECT_EQ("", session.Out().View());
+    session.Receive("0000 -p");
+    session.Receive("4 zz 40490FDB");
+    EXPECT_EQ("1\nline 1, byte 13: zz is not recognized.\n", session.Out().View());
+    EXPECT_FALSE(session.Done());
+    session.End();
+    EXPECT_EQ("1\nline 1, byte 13: zz is not recognized.\n3.142\n", session.Out().View());
+    EXPECT_TRUE(session.Done());
+
+    // each session starts from the settings it was given.
+    ::Session other(settings);
+
+    other.Receive("40490FDB Q 3F800000\n");
+    EXPECT_EQ("3.1\n", other.Out().View());
+    EXPECT_TRUE(other.Done());
+}
+
+TEST(RecordTest, jsonAndCsv) {
+    auto convert = [](std::string_view block)
+                   {
+                       ::Settings     settings;
+                       ::OutputBuffer out;
+                       ::ErrorLog     errors(out, settings.maxErrors);
+
+                       errors.StartBlock(block, ::Position());
+                       ::ConvertTextBlock(settings, block, out, errors);
+                       return std::string(out.View());
+                   };
+
+    EXPECT_EQ("{\"hex\":\"3F800000\",\"type\":\"float\",\"value\":1,\"sign\":0,"
+              "\"exponent\":127,\"mantissa\":0,\"class\":\"Normal\"}\n"
+              "{\"hex\":\"00000001\",\"type\":\"float\",\"value\":1.4e-45,\"sign\":0,"
+              "\"exponent\":0,\"mantissa\":1,\"class\":\"Subnormal\"}\n"
+              "{\"hex\":\"7FC00000\",\"type\":\"float\",\"value\":\"nan\",\"sign\":0,"
+              "\"exponent\":255,\"mantissa\":4194304,\"class\":\"NaN\"}\n"
+              "{\"hex\":\"FF800000\",\"type\":\"float\",\"value\":\"-inf\",\"sign\":1,"
+              "\"exponent\":255,\"mantissa\":0,\"class\":\"Infinity\"}\n"
+              "{\"hex\":\"400921FB54442D18\",\"type\":\"double\",\"value\":3.1,\"sign\":0,"
+              "\"exponent\":1024,\"mantissa\":2570638124657944,\"class\":\"Normal\"}\n",
+              convert("-ojson 3F800000 00000001 7FC00000 FF800000 400921FB54442D18"));
+
+    // the header comes again where CSV is switched back on, not where it
+    // is asked for again.
+    EXPECT_EQ("hex,type,value,sign,exponent,mantissa,class\n"
+              "3F800000,float,1,0,127,0,Normal\n"
+              "00000001,float,1.4e-45,0,0,1,Subnormal\n"
+              "7FC00000,float,nan,0,255,4194304,NaN\n"
+              "{\"hex\":\"FF800000\",\"type\":\"float\",\"value\":\"-inf\",\"sign\":1,"
+              "\"exponent\":255,\"mantissa\":0,\"class\":\"Infinity\"}\n"
+              "hex,type,value,sign,exponent,mantissa,class\n"
+              "400921FB54442D18,double,3.1,0,1024,2570638124657944,Normal\n",
+              convert("-ocsv 3F800000 -ocsv 00000001 7FC00000 -ojson FF800000 -ocsv "
+                      "400921FB54442D18"));
+}
+
+TEST(FilterTest, parseAndPass) {
+    ::Settings settings;
+
+    auto passes = [&](ieee754::Bits bits)
+                  {
+                      ieee754::IEEE754Float<float> value;
+
+                      value = bits;
+                      return ieee754::Passes(settings.filter, value);
+                  };
+
+    EXPECT_FALSE(ieee754::IsFiltering(settings.filter));
+
+    // classes: any of those listed.
+    ASSERT_TRUE(::InterpretMode(settings, "--only=zero,NaN"));
+    EXPECT_TRUE(passes(0x80000000));
+    EXPECT_TRUE(passes(0x7FC00000));
+    EXPECT_FALSE(passes(0x3F800000));
+    EXPECT_FALSE(passes(0x00000001));
+
+    // signs and classes: one of each.
+    ASSERT_TRUE(::InterpretMode(settings, "--only=negative,normal,infinity"));
+    EXPECT_TRUE(passes(0xBF800000));
+    EXPECT_TRUE(passes(0xFF800000));
+    EXPECT_FALSE(passes(0x3F800000));
+    EXPECT_FALSE(passes(0x80000001));
+    ASSERT_TRUE(::InterpretMode(settings, "--only=positive"));
+    EXPECT_TRUE(passes(0x00000001));
+    EXPECT_FALSE(passes(0x80000000));
+
+    // inclusive bounds of the unbiased exponent, subnormals have -126.
+    ASSERT_TRUE(::InterpretMode(settings, "--only=exp=-126:0"));
+    EXPECT_TRUE(passes(0x00000001));
+    EXPECT_TRUE(passes(0x00800000));
+    EXPECT_TRUE(passes(0xBF800000));
+    EXPECT_FALSE(passes(0x40000000));
+    ASSERT_TRUE(::InterpretMode(settings, "--only=exp=1:"));
+    EXPECT_TRUE(passes(0x40000000));
+    EXPECT_TRUE(passes(0x7F800000));
+    EXPECT_FALSE(passes(0x3F800000));
+    ASSERT_TRUE(::InterpretMode(settings, "--only=exp=-125"));
+    EXPECT_FALSE(passes(0x00000001));
+    EXPECT_TRUE(passes(0x01000000));
+
+    ASSERT_TRUE(::InterpretMode(settings, "--only=all"));
+    EXPECT_FALSE(ieee754::IsFiltering(settings.filter));
+    ASSERT_TRUE(::InterpretMode(settings, "--only=nan,all"));
+    EXPECT_FALSE(ieee754::IsFiltering(settings.filter));
+
+    // a bad spec leaves the filter as it was.
+    ASSERT_TRUE(::InterpretMode(settings, "--only=subnormal"));
+    EXPECT_FALSE(::InterpretMode(settings, "--only=exp=3:1"));
+    EXPECT_FALSE(::InterpretMode(settings, "--only=exp=1:x"));
+    EXPECT_FALSE(::InterpretMode(settings, "--only=exp="));
+    EXPECT_FALSE(::InterpretMode(settings, "--only=normal,tiny"));
+    EXPECT_TRUE(passes(0x00000001));
+    EXPECT_FALSE(passes(0x3F800000));
+    ::lastError = ::Error::None;
+}
+
+TEST(FilterTest, summaryCountsFiltered) {
+    auto summarize = [](std::string_view block, const char *filter)
+                     {
+                         ::Settings     settings;
+                         ::OutputBuffer out;
+                         ::ErrorLog     errors(out, settings.maxErrors);
+
+                         settings.summary = true;
+                         EXPECT_TRUE(::InterpretMode(settings, filter));
+                         errors.StartBlock(block, ::Position());
+                         ::ConvertTextBlock(settings, block, out, errors).summary.Print(out);
+                         return std::string(out.View());
+                     };
+    const std::string filtered = summarize("3F800000 BF800000 00000001 FF800000 C0000000 0 "
+                                           "400921FB54442D18 C00921FB54442D18",
+                                           "--only=negative,normal");
+
+    EXPECT_EQ(summarize("BF800000 C0000000 C00921FB54442D18", "--only=all"), filtered);
+    EXPECT_EQ(0u, filtered.find("Summary of 2 float values:\n"));
+    EXPECT_NE(std::string::npos, filtered.find("Summary of 1 double values:\n"));
+}
+
+TEST(StatsTest, countsTokens) {
+    ::Settings     settings;
+    ::OutputBuffer out;
+
+    settings.stats = true;
+    ::MergeThreadStats();
+    ::totalStats = ::Stats();
+    ::ErrorLog         errors(out, settings.maxErrors);
+    std::string_view   block = "3F800000 -s zz 0000000000000001 FF800000 0x3FF000000000000G -pq";
+
+    errors.StartBlock(block, ::Position());
+    ::ConvertTextBlock(settings, block, out, errors);
+    ::MergeThreadStats();
+    ::lastError = ::Error::None;
+
+    EXPECT_EQ(7u, ::totalStats.tokens);
+    EXPECT_EQ(2u, ::totalStats.values[static_cast<unsigned>(::Input::Float)
+                                      - static_cast<unsigned>(::Input::Half)]);
+    EXPECT_EQ(1u, ::totalStats.values[static_cast<unsigned>(::Input::Double)
+                                      - static_cast<unsigned>(::Input::Half)]);
+    EXPECT_EQ(3u, ::totalStats.invalid);
+    EXPECT_EQ(1u, ::totalStats.invalidWidths[static_cast<unsigned>(hex::Width::Float)]);
+    EXPECT_EQ(1u, ::totalStats.invalidWidths[static_cast<unsigned>(hex::Width::Double)]);
+    EXPECT_EQ(1u, ::totalStats.invalidWidths[static_cast<unsigned>(hex::Width::Bad)]);
+    EXPECT_EQ(1u, ::totalStats.flags);
+    EXPECT_EQ(1u, ::totalStats.classes[static_cast<unsigned>(::FloatClass::Subnormal)]);
+    EXPECT_EQ(1u, ::totalStats.classes[static_cast<unsigned>(::FloatClass::Infinity)]);
+}
+
+TEST(StatsTest, cacheKeepsOutput) {
+    ::Settings       settings;
+    ::Settings       cached;
+    ::OutputBuffer   out;
+    ::OutputBuffer   cachedOut;
+    ::ErrorLog       errors(out, settings.maxErrors);
+    std::string_view block = "3F800000 3F800000 -s 3F800000 -p5 3F800000 3F80 3F800000";
+
+    cached.stats     = true;
+    cached.cacheSize = 8;
+    ::MergeThreadStats();
+    ::totalStats = ::Stats();
+    errors.StartBlock(block, ::Position());
+    ::ConvertTextBlock(settings, block, out, errors);
+    errors.StartBlock(block, ::Position());
+    ::ConvertTextBlock(cached, block, cachedOut, errors);
+    ::MergeThreadStats();
+
+    EXPECT_EQ(out.View(), cachedOut.View());
+    EXPECT_EQ(2u, ::totalStats.cacheHits);
+    EXPECT_EQ(4u, ::totalStats.cacheMisses);
+}
+
+TEST(SweepTest, matchesHexInput) {
+    ::Settings     settings;
+    ::OutputBuffer out;
+    ::OutputBuffer swept;
+    ::ErrorLog     errors(out, settings.maxErrors);
+    std::string    block;
+    ieee754::Type  type;
+    ::Bits         first;
+    ::Bits         last;
+
+    ASSERT_TRUE(::InterpretMode(settings, "--sweep=7F7FFFF0:0x7F800010:3", true));
+    ASSERT_TRUE(::GetSweepRange(settings, type, first, last, out));
+    EXPECT_EQ(ieee754::Type::Float, type);
+
+    for(std::uint32_t bits = 0x7F7FFFF0; bits <= 0x7F800010; bits += 3)
+    {
+        char hex[8];
+
+        block.append(hex, ::FormatHex(hex, bits, 8) - hex).push_back('\n');
+    }
+    errors.StartBlock(block, ::Position());
+    ::ConvertTextBlock(settings, block, out, errors);
+    ::Sweep(settings, type, first, last, swept);
+    EXPECT_EQ(out.View(), swept.View());
+
+    settings.type = ieee754::Type::Half;
+    swept.Clear();
+    EXPECT_FALSE(::GetSweepRange(settings, type, first, last, swept));
+    EXPECT_EQ("Error: The ends of --sweep do not fit the type of -t.\n", swept.View());
+    EXPECT_FALSE(::InterpretMode(settings, "--sweep=1:2:0", true));
+    ::lastError = ::Error::None;
+}
+
+TEST(ConvertPathTest, fileMatchesBlock) {
+    const std::string_view text = "3F800000 -s zz 40490FDB\n-p4 0000000000000001";
+    char                   path[] = "/tmp/float-test-XXXXXX";
+    int                    fd     = ::mkstemp(path);
+    ::OutputBuffer         expected;
+    ::OutputBuffer         out;
+    ::ErrorLog             errors(out, ::Settings().maxErrors);
+    bool                   bad = false;
 
-        T GetIEEEFloat()
+    ASSERT_LE(0, fd);
+    ASSERT_EQ(static_cast<ssize_t>(text.size()), ::write(fd, text.data(), text.size()));
+    ::close(fd);
+
+    ::Settings settings;
+    ::ErrorLog expectedErrors(expected, settings.maxErrors);
+
+    expectedErrors.StartBlock(text, ::Position());
+    ::ConvertTextBlock(settings, text, expected, expectedErrors);
+
+    ::currentSettings = ::Settings();
+    ::ConvertPath(path, out, errors, bad);
+    EXPECT_FALSE(bad);
+    EXPECT_EQ(expected.View(), out.View());
+
+    ::unlink(path);
+    out.Clear();
+    ::ConvertPath(path, out, errors, bad);
+    EXPECT_TRUE(bad);
+    EXPECT_EQ(0u, out.View().find("Error: could not open "));
+    ::currentSettings = ::Settings();
+    ::lastError       = ::Error::None;
+}
+
+TEST(ConvertPathTest, stdinFromItsPosition) {
+    const std::string_view text   = "3F800000\n40490FDB\n";
+    char                   path[] = "/tmp/float-test-XXXXXX";
+    int                    fd     = ::mkstemp(path);
+    int                    stdinFd = ::dup(STDIN_FILENO);
+    char                   line[9];
+    ::OutputBuffer         out;
+    ::ErrorLog             errors(out, ::Settings().maxErrors);
+    bool                   bad = false;
+
+    ASSERT_LE(0, fd);
+    ASSERT_EQ(static_cast<ssize_t>(text.size()), ::write(fd, text.data(), text.size()));
+    ::unlink(path);
+
+    // the first line was read by someone else, as "read -r l" would.
+    ::lseek(fd, 0, SEEK_SET);
+    ASSERT_EQ(9, ::read(fd, line, sizeof(line)));
+    ASSERT_EQ(STDIN_FILENO, ::dup2(fd, STDIN_FILENO));
+
+    ::currentSettings              = ::Settings();
+    ::currentSettings.simpleOutput = true;
+    ::ConvertPath("-", out, errors, bad);
+    EXPECT_EQ("3.1\n", out.View());
+    EXPECT_EQ(static_cast<off_t>(text.size()), ::lseek(STDIN_FILENO, 0, SEEK_CUR));
+
+    ::dup2(stdinFd, STDIN_FILENO);
+    ::close(stdinFd);
+    ::close(fd);
+    ::currentSettings = ::Settings();
+}
+
+TEST(BlockReaderTest, tokensAcrossBlocks) {
+    const std::string_view text = "3F800000 400921FB54442D18\n-p4 0000000000000001 -s 40490FDB";
+    ::OutputBuffer         expected;
+    ::OutputBuffer         out;
+    int                    fds[2];
+
+    ASSERT_EQ(0, ::pipe(fds));
+    ASSERT_EQ(static_cast<ssize_t>(text.size()), ::write(fds[1], text.data(), text.size()));
+    ::close(fds[1]);
+
+    ::Settings settings;
+    ::ErrorLog expectedErrors(expected, settings.maxErrors);
+    ::ErrorLog errors(out, settings.maxErrors);
+
+    expectedErrors.StartBlock(text, ::Position());
+    ::ConvertTextBlock(settings, text, expected, expectedErrors);
+
+    // 8 byte blocks cut both 16 digit tokens, which must be carried over.
+    ::BlockReader reader(fds[0], 8);
+
+    ::currentSettings = ::Settings();
+    ::Convert(reader, out, errors);
+    EXPECT_FALSE(reader.Bad());
+    EXPECT_EQ(expected.View(), out.View());
+    EXPECT_NE(std::string_view::npos, out.View().find("3.1\n"));
+
+    ::close(fds[0]);
+    ::currentSettings = ::Settings();
+}
+
+TEST(ParallelTest, inOrderAcrossChunks) {
+    std::string text;
+
+    for(int i = 0; i < 40; i++)
+    {
+        text += "3F800000 zz -s 40490FDB\n-p4 0000000000000001 -p2 ";
+        text += (i % 2) ? "-ojson C0000000 -otext\n" : "BF800000 -s\n";
+    }
+    // nothing after the quit is written, values or errors.
+    text += "7F800000 q 3F8CCCCD yy -s 40A00000\n";
+
+    ::Settings     settings;
+    ::OutputBuffer expected;
+    ::OutputBuffer expectedErr;
+    ::ErrorLog     expectedErrors(expectedErr, settings.maxErrors);
+
+    expectedErrors.StartBlock(text, ::Position());
+    ASSERT_TRUE(::ConvertTextBlock(settings, text, expected, expectedErrors).stop);
+    ASSERT_EQ(std::string_view::npos, expectedErr.View().find("yy"));
+    ASSERT_EQ(std::string_view::npos, expected.View().find("\n1.1\n"));
+
+    // blocks of a few tokens, so the flags fall on every side of a cut.
+    for(std::size_t blockSize : { 7, 16, 29, 64, 256 })
+    {
+        for(unsigned threads : { 1, 4 })
         {
-            return _float;
+            ::OutputBuffer out;
+            ::OutputBuffer err;
+            ::ErrorLog     errors(err, settings.maxErrors);
+            int            fds[2];
+
+            SCOPED_TRACE(testing::Message() << blockSize << " byte blocks, -j" << threads);
+            ASSERT_EQ(0, ::pipe(fds));
+            ASSERT_EQ(static_cast<ssize_t>(text.size()), ::write(fds[1], text.data(), text.size()));
+            ::close(fds[1]);
+
+            ::BlockReader reader(fds[0], blockSize);
+
+            ::currentSettings         = ::Settings();
+            ::currentSettings.threads = threads;
+
+            ::BlockResult result = ::ConvertInput(reader, out, errors);
+
+            EXPECT_TRUE(result.stop);
+            EXPECT_EQ(expected.View(), out.View());
+            EXPECT_EQ(expectedErr.View(), err.View());
+            ::close(fds[0]);
         }
+    }
 
-        ~IEEE754Float() = default;
+    ::currentSettings = ::Settings();
+    ::lastError       = ::Error::None;
+}
 
-    };
+TEST(RawTest, byteOrdersAndTail) {
+    // 1 and pi as floats, then pi as a double, in both byte orders, and a
+    // 3 byte tail that is not a whole value.
+    const std::string_view little("\x00\x00\x80\x3F\xDB\x0F\x49\x40\x01\x02\x03", 11);
+    const std::string_view big("\x3F\x80\x00\x00\x40\x49\x0F\xDB\x01\x02\x03", 11);
+    const std::string_view littleDouble("\x18\x2D\x44\x54\xFB\x21\x09\x40", 8);
+    const std::string_view bigDouble("\x40\x09\x21\xFB\x54\x44\x2D\x18", 8);
+
+    auto convert = [](const char *spec, std::string_view block)
+                   {
+                       ::Settings     settings;
+                       ::OutputBuffer out;
+                       ::ErrorLog     errors(out, settings.maxErrors);
+
+                       settings.simpleOutput = true;
+                       EXPECT_TRUE(::InterpretMode(settings, spec, true));
+                       errors.StartBlock(block, ::Position());
+
+                       ::BlockResult result = ::ConvertRawBlock(settings, block, out, errors);
 
-    // aliases
-    using Float  = IEEE754Float<float>;
-    using Double = IEEE754Float<double>;
+                       return std::make_pair(std::string(out.View()), result.numFailedInputs);
+                   };
+    const std::string tail = "1\n3.1\nbyte 8: Input ended with 3 bytes of an incomplete value.\n";
+
+    EXPECT_EQ(std::make_pair(tail, 1), convert("-b4", little));
+    EXPECT_EQ(std::make_pair(tail, 1), convert("-b4l", little));
+    EXPECT_EQ(std::make_pair(tail, 1), convert("-b4B", big));
+    EXPECT_EQ(std::make_pair(std::string("3.1\n"), 0), convert("-b8L", littleDouble));
+    EXPECT_EQ(std::make_pair(std::string("3.1\n"), 0), convert("-b8b", bigDouble));
+
+    ::Settings settings;
+
+    EXPECT_FALSE(::InterpretMode(settings, "-b2", true));
+    EXPECT_FALSE(::InterpretMode(settings, "-b4x", true));
+    EXPECT_FALSE(::InterpretMode(settings, "-b4lb", true));
+    EXPECT_EQ(0u, settings.rawSize);
+    ::lastError = ::Error::None;
+}
 
-    // TODO maybe do long double.
-    
-    /*
-     * Determine if the input was a float or double. If it was neither, return BadInput.
-     */
-    ::Input IsFloatOrDouble(const std::string_view str)
+TEST(DiffTest, ulpAndFields) {
+    ::Settings     settings;
+    ::OutputBuffer out;
+    bool           bad = false;
+    int            first[2];
+    int            second[2];
+
+    ASSERT_EQ(0, ::pipe(first));
+    ASSERT_EQ(0, ::pipe(second));
+    for(auto [fd, text] : { std::pair<int, std::string_view>(first[1], "3F800000 zz 80000000 1 2"),
+                            std::pair<int, std::string_view>(second[1], "3F800002 zz 00000000 1") })
     {
-        constexpr std::size_t floatSize = sizeof(float) * 2;
-        constexpr std::size_t doubleSize = sizeof(double) * 2;
-        ::Input               result = Input::BadInput;
+        ASSERT_EQ(static_cast<ssize_t>(text.size()), ::write(fd, text.data(), text.size()));
+        ::close(fd);
+    }
 
-        auto check = [&]() -> bool
-        {
-            constexpr char beginHexAscii = 65; // A
-            constexpr char endHexAscii   = 70; // F
+    ::DiffSummary summary = ::Diff(settings, first[0], second[0], out, bad);
 
-            for(char c : str)
-            {
-                // return false if char is not alphanumeric and in the Hex char range.
-                if(!std::isdigit(c))
-                {
-                    if(c < beginHexAscii
-                       || c > endHexAscii)
-                    {
-                        return false;
-                    }
-                }
-            }
+    ::close(first[0]);
+    ::close(second[0]);
+    EXPECT_FALSE(bad);
+    EXPECT_EQ(4u, summary.compared);
+    EXPECT_EQ(2u, summary.differing);
+    EXPECT_EQ(1u, summary.notValues);
+    EXPECT_EQ(1u, summary.onlyFirst);
+    EXPECT_TRUE(summary.maxUlp == 2);
+    EXPECT_EQ(0u, out.View().find("1: 3F800000 3F800002 float: 1 vs 1.0000002, 2 ulp, "
+                                  "exponent +0, mantissa +2\n"
+                                  "3: 80000000 00000000 float: -0 vs 0, 1 ulp, sign flipped, "
+                                  "exponent +0, mantissa +0\n"));
+}
 
-            return true;
-        };
+/* A Reader of a string, as one block. */
+struct StringReader {
+    std::string_view text;
 
+    std::string_view Next() {
+        std::string_view block = text;
 
-        switch(str.size())
-        {
-        case 0 ... floatSize:
-            if(check())
-            {
-                result = ::Input::Float;
-            }
-            break;
+        text = std::string_view();
+        return block;
+    }
 
-        case (floatSize + 1) ... doubleSize:
-            if(check())
-            {
-                result = ::Input::Double;
-            }
-            break;
+    bool Bad() const {
+        return false;
+    }
+};
+
+TEST(DumpReaderTest, layouts) {
+    const std::string expected("\x00\x00\x80\x3f\xd0\x0f\x49\x40" "\0\0\0\0\0\0\0\0"
+                               "\0\0\0\0\0\0\0\0" "\0\0\0\0\0\0\0\0" "\x00\x00\x20\xc1", 36);
+    const std::pair<::DumpFormat, std::string_view> dumps[] =
+    {
+        { ::DumpFormat::Xxd, "00000000: 0000 803f d00f 4940 0000 0000 0000 0000  ...?..I@........\n"
+                             "00000010: 0000 0000 0000 0000 0000 0000 0000 0000  ................\n"
+                             "00000020: 0000 20c1                                .. .\n" },
+        { ::DumpFormat::Od, "0000000 0000 3f80 0fd0 4049 0000 0000 0000 0000\n"
+                            "0000020 0000 0000 0000 0000 0000 0000 0000 0000\n"
+                            "*\n"
+                            "0000040 0000 c120\n"
+                            "0000044\n" },
+        { ::DumpFormat::Hexdump, "00000000  00 00 80 3f d0 0f 49 40  00 00 00 00 00 00 00 00  |...?..I@........|\n"
+                                 "00000010  00 00 00 00 00 00 00 00  00 00 00 00 00 00 00 00  |................|\n"
+                                 "*\n"
+                                 "00000020  00 00 20 c1                                       |.. .|\n"
+                                 "00000024\n" },
+        { ::DumpFormat::Gdb, "(gdb) x/9xw &a\n"
+                             "0x601040 <a>:\t0x3f800000\t0x40490fd0\t0x00000000\t0x00000000\n"
+                             "0x601050 <a+16>:\t0x00000000\t0x00000000\t0x00000000\t0x00000000\n"
+                             "0x601060 <a+32>:\t0xc1200000" },
+        // C++ symbols, with colons and template brackets of their own.
+        { ::DumpFormat::Gdb, "0x401136 <ns::a>:\t0x3f800000\t0x40490fd0\t0x00000000\t0x00000000\n"
+                             "0x401146 <std::array<float, 9ul>::_M_elems+16>:\t0x00000000\t"
+                             "0x00000000\t0x00000000\t0x00000000\n"
+                             "0x401156 <ns::a+32>:\t0xc1200000" },
+    };
+
+    for(auto [format, text] : dumps)
+    {
+        ::StringReader               reader{ text };
+        ::DumpReader<::StringReader> dump(reader, format);
+        std::string                  bytes;
+        std::string_view             block;
+
+        while(!(block = dump.NextUnits(8)).empty())
+        {
+            bytes.append(block);
         }
+        EXPECT_EQ(expected, bytes) << text;
+    }
+}
+
+TEST(StatsTest, dumpCountsItsText) {
+    const std::string_view text = "00000000: 0000 803f d00f 4940  ...?..I@\n";
+    ::StringReader         reader{ text };
+    ::OutputBuffer         out;
+    ::ErrorLog             errors(out, 0);
+
+    ::currentSettings = ::Settings();
+    ASSERT_TRUE(::InterpretMode(::currentSettings, "--dump=xxd", true));
+    ::currentSettings.stats = true;
+    ::MergeThreadStats();
+    ::totalStats = ::Stats();
+
+    ::DumpReader<::StringReader> dump(reader, ::currentSettings.dump);
+
+    EXPECT_EQ(0, ::ConvertInput(dump, out, errors).numFailedInputs);
+    ::MergeThreadStats();
+    ::currentSettings = ::Settings();
+
+    EXPECT_EQ(text.size(), ::totalStats.bytesIn);
+    EXPECT_EQ(2u, ::totalStats.values[static_cast<unsigned>(::Input::Float)
+                                      - static_cast<unsigned>(::Input::Half)]);
+}
+
+/* Reads all of reader's blocks, checking that each one but the last ends
+   where unitSize says (after a separator if 0). */
+template<typename Reader>
+static std::string ReadAll(Reader &reader, std::size_t unitSize) {
+    std::string      text;
+    std::string_view block;
+    bool             whole = true; // the block before ended where it should
 
-        return result;
+    while(!(block = (unitSize == 0) ? reader.Next() : reader.NextUnits(unitSize)).empty())
+    {
+        EXPECT_TRUE(whole);
+        whole = (unitSize == 0) ? ::IsSpace(block.back()) : ((block.size() % unitSize) == 0);
+        text.append(block);
     }
+    EXPECT_FALSE(reader.Bad());
+    return text;
+}
 
-    /*
-     * Gets program's interpretaion of the input that the user has put in.
-     */
-    ::Input GetInputType(const std::string_view str)
+TEST(OutputBufferTest, sendKeepsOrder) {
+    std::FILE     *file = std::tmpfile();
+    char           text[16];
+    ::OutputBuffer chunk;
+
+    ASSERT_NE(nullptr, file);
     {
-        ::Input input; // return value
+        ::OutputBuffer out(::fileno(file));
+
+        out.Write("1\n");
+        chunk.Write("2\n");
+        EXPECT_TRUE(out.Send(chunk));
+        out.Write("3\n");
+    }
+    EXPECT_EQ("", chunk.View());
+    ::lseek(::fileno(file), 0, SEEK_SET);
+    EXPECT_EQ(6, ::read(::fileno(file), text, sizeof(text)));
+    EXPECT_EQ("1\n2\n3\n", std::string_view(text, 6));
+    std::fclose(file);
+}
 
-        // quit
-        if(str[0] == 'Q')
+TEST(UringTest, readsAndWrites) {
+    std::string text;
+    char        token[16];
+    int         fds[2];
+
+    // several reads' worth, with tokens cut by the ends of reads.
+    for(unsigned i = 0; i < 300000; i++)
+    {
+        text.append(token, std::snprintf(token, sizeof(token), "%X\n", i * 2654435761u));
+    }
+
+    // a pipe, one read at a time.
+    ASSERT_EQ(0, ::pipe(fds));
+    std::thread writer([&]() { ::write(fds[1], text.data(), text.size()); ::close(fds[1]); });
+    {
+        ::UringReader reader(fds[0]);
+
+        if(!reader.Setup())
         {
-            input = ::Input::Exit;
+            writer.join();
+            ::close(fds[0]);
+            GTEST_SKIP() << "io_uring is not available";
         }
-        // flag
-        else if(str[0] == '-')
+        EXPECT_EQ(text, ::ReadAll(reader, 0));
+    }
+    writer.join();
+    ::close(fds[0]);
+
+    // a file, several reads at once.
+    std::FILE *file = std::tmpfile();
+
+    ASSERT_NE(nullptr, file);
+    ASSERT_EQ(static_cast<ssize_t>(text.size()), ::write(::fileno(file), text.data(), text.size()));
+    for(std::size_t unitSize : { 0, 8 })
+    {
+        ::lseek(::fileno(file), 0, SEEK_SET);
+
+        ::UringReader reader(::fileno(file));
+
+        ASSERT_TRUE(reader.Setup());
+        EXPECT_EQ(text, ::ReadAll(reader, unitSize));
+    }
+    std::fclose(file);
+
+    // output written while the next is collected, in order.
+    std::string written;
+
+    ASSERT_EQ(0, ::pipe(fds));
+    std::thread drain([&]() {
+        char    buf[4096];
+        ssize_t size;
+
+        while((size = ::read(fds[0], buf, sizeof(buf))) > 0)
         {
-//            char firstChar = str[0];
-            input = ::Input::Mode;
+            written.append(buf, size);
         }
-        // a float or double
-        else
+    });
+    {
+        ::OutputBuffer out(fds[1]);
+        ::OutputBuffer chunk;
+
+        ASSERT_TRUE(out.WriteAsync());
+        for(std::size_t i = 0; i < text.size(); i += 100000)
         {
-            input = ::IsFloatOrDouble(str);
+            ((i % 200000) ? out : chunk).Write(text.substr(i, 100000));
+            EXPECT_TRUE((i % 200000) ? out.Flush() : out.Send(chunk));
         }
+        EXPECT_TRUE(out.Finish());
+    }
+    ::close(fds[1]);
+    drain.join();
+    ::close(fds[0]);
+    EXPECT_EQ(text, written);
+
+    // a failed write is kept for the exit status, with io_uring or without.
+    for(bool async : { false, true })
+    {
+        int full = ::open("/dev/full", O_WRONLY);
+
+        ASSERT_LE(0, full);
+        {
+            ::OutputBuffer out(full);
 
-        return input;
+            EXPECT_EQ(async, async && out.WriteAsync());
+            out.Write("1\n");
+            EXPECT_FALSE(out.Finish());
+            EXPECT_EQ(ENOSPC, out.Error());
+        }
+        ::close(full);
     }
+}
+
+TEST(ErrorLogTest, positionsAndLimit) {
+    ::OutputBuffer   out;
+    ::ErrorLog       errors(out, 2);
+    ::Settings       settings;
+    std::string_view block = "3F800000\nzz -p\n\n  -pq\n- 40490FDB";
 
+    settings.simpleOutput = true;
+    errors.StartBlock(block, ::Position{ 10, 100 });
+    EXPECT_EQ(4, ::ConvertTextBlock(settings, block, out, errors).numFailedInputs);
+    EXPECT_EQ("1\n"
+              "line 11, byte 109: zz is not recognized.\n"
+              "line 11, byte 112: -p is not recognized. Precision was not set with value.\n"
+              "3.1\n",
+              out.View());
+
+    out.Clear();
+    errors.PrintHidden();
+    EXPECT_EQ("2 more errors were not shown. All errors:\n"
+              "    1 not a value\n"
+              "    1 short flag\n"
+              "    1 no precision\n"
+              "    1 bad precision\n",
+              out.View());
 }
 
-TEST(InputTypeTest, quitType) {
-    ::Input input = ::GetInputType("Q");
-    ASSERT_EQ(::Input::Exit, input);
+TEST(ErrorLogTest, commandLine) {
+    ::OutputBuffer err;
+    ::Settings     settings;
+
+    EXPECT_FALSE(::InterpretMode(settings, "-pq", true));
+    ::PrintError(err, ::lastError, "-pq", ::lastErrorDetail);
+    ::PrintError(err, ::Error::DiffNeedsTwoFiles);
+    ::PrintError(err, ::Error::NotAValue, "-");
+    EXPECT_EQ("Error: -pq is not recognized. While trying to set the float precision: "
+              "q is not a valid number.\n"
+              "Error: --diff needs two files.\n"
+              "Error: - is not recognized.\n",
+              err.View());
+    ::lastError = ::Error::None;
 }
 
-TEST(InputTypeTest, flagType) {
-    ::Input input = ::GetInputType("-A");
-    ASSERT_EQ(::Input::Mode, input);
+TEST(HexDecodeTest, allDecodersAgree) {
+    std::mt19937_64 rng(754);
+
+    for(int i = 0; i < 10000; i++)
+    {
+        std::uint64_t expected = rng() >> (rng() % 64);
+        char          buf[32];
+        int           len = std::snprintf(buf, sizeof(buf), (i % 2) ? "%lx" : "%lX",
+                                          static_cast<unsigned long>(expected));
+        std::string_view str(buf, len);
+
+        ASSERT_EQ(expected, hex::detail::DecodeScalar(str)) << str;
+        ASSERT_EQ(expected, hex::detail::DecodeSSE2(str)) << str;
+        ASSERT_EQ(expected, hex::Decode(str)) << str;
+        if(__builtin_cpu_supports("ssse3"))
+        {
+            ASSERT_EQ(expected, hex::detail::DecodeSSSE3(str)) << str;
+        }
+    }
 }
 
-TEST(InputTypeTest, ford) {
-    ::Input input = ::IsFloatOrDouble("DEAD");
-    EXPECT_EQ(::Input::Float, input);
+TEST(HexDecodeTest, batch) {
+    std::string_view strs[] = { "3F800000", "400921fb54442d18", "0", "DEAD", "ffffffffffffffff" };
+    std::uint64_t    out[5];
+
+    hex::Decode(strs, 5, out);
+    EXPECT_EQ(0x3F800000u, out[0]);
+    EXPECT_EQ(0x400921FB54442D18u, out[1]);
+    EXPECT_EQ(0u, out[2]);
+    EXPECT_EQ(0xDEADu, out[3]);
+    EXPECT_EQ(~0ull, out[4]);
+}
+
+TEST(HexScanTest, widths) {
+    EXPECT_EQ(hex::Width::Float, hex::Scan("DEAD").width);
+    EXPECT_EQ(hex::Width::Float, hex::Scan("0x3f800000").width);
+    EXPECT_EQ(hex::Width::Double, hex::Scan("0X400921FB54442D18").width);
+    EXPECT_EQ(hex::Width::Double, hex::Scan("123456789").width);
+    EXPECT_EQ(hex::Width::Bad, hex::Scan("0x").width);
+    EXPECT_EQ(hex::Width::Extended, hex::Scan("12345678901234567").width);
+    EXPECT_EQ(hex::Width::Quad, hex::Scan("123456789012345678901").width);
+    EXPECT_EQ(hex::Width::Bad, hex::Scan("123456789012345678901234567890123").width);
+    EXPECT_EQ(hex::Width::Bad, hex::Scan("x23456789012345678901").width);
+    EXPECT_EQ(0x3FFFu, hex::Scan("3FFF8000000000000000").high);
+    EXPECT_EQ(0x8000000000000000u, hex::Scan("3FFF8000000000000000").value);
+    EXPECT_EQ(hex::Width::Bad, hex::Scan("3f80000g").width);
+    EXPECT_EQ(hex::Width::Bad, hex::Scan("3f8000:0").width);
+    EXPECT_EQ(hex::Width::Bad, hex::Scan("\x10").width);
+    EXPECT_EQ(0x3F800000u, hex::Scan("0x3F800000").value);
+    EXPECT_EQ("3F800000", hex::Scan("0x3F800000").digits);
+}
+
+TEST(HexScanTest, matchesScalar) {
+    // every single character token
+    for(int c = 1; c < 256; c++)
+    {
+        char             buf[] = { '1', static_cast<char>(c) };
+        std::string_view str(buf, sizeof(buf));
+
+        EXPECT_EQ(hex::detail::ScanScalar(str).width, hex::detail::ScanSSE2(str).width) << c;
+        EXPECT_EQ(hex::detail::ScanScalar(str).width, hex::Scan(str).width) << c;
+        if(hex::Scan(str).width != hex::Width::Bad)
+        {
+            EXPECT_EQ(hex::detail::ScanScalar(str).value, hex::Scan(str).value) << c;
+        }
+    }
 }
 
 int main(int argc, char *argv[])
@@ -0,0 +1,50 @@
+/*
+ * Writes a corpus from corpus.hpp to standard out, to time float end to end:
+ *
+ *     gen-corpus <uniform|nan|subnormal|mixed|invalid> <count> [seed]
+ */
+
+#include <iostream>    // cout, cerr
+#include <string_view> // string_view
+#include <charconv>    // from_chars
+#include <cstdint>     // uint64_t
+#include <cstring>     // strlen
+
+#include "corpus.hpp"
+
+namespace
+{
+    /* Parses a whole argument as a number. */
+    static bool ParseNumber(const char *arg, std::uint64_t &number)
+    {
+        const char *end = arg + std::strlen(arg);
+        auto [ptr, ec]  = std::from_chars(arg, end, number);
+
+        return (ec == std::errc()) && (ptr == end) && (ptr != arg);
+    }
+}
+
+int main(const int argc, const char *argv[])
+{
+    std::uint64_t count = 0;
+    std::uint64_t seed  = 1;
+
+    if((argc < 3) || (argc > 4) || !::ParseNumber(argv[2], count)
+       || ((argc == 4) && !::ParseNumber(argv[3], seed)))
+    {
+        std::cerr << "Usage: gen-corpus <uniform|nan|subnormal|mixed|invalid> <count> [seed]\n";
+        return -2;
+    }
+
+    for(corpus::Kind kind : corpus::kinds)
+    {
+        if(std::string_view(argv[1]) == corpus::Name(kind))
+        {
+            std::cout << corpus::Make(kind, count, seed);
+            return 0;
+        }
+    }
+
+    std::cerr << "Unknown corpus: " << argv[1] << '\n';
+    return -2;
+}